@@ -82,6 +82,8 @@ enum book_info_action {
   BI_CLICK
 };
 
+#define SAVE_VERSION  1
+
 struct save_st {
   u32 checksum;
   u32 books;
@@ -93,7 +95,42 @@ struct save_st {
   u8 songvol;
   u8 sfxvol;
   u8 brightness;
-  struct game_st game;
+  u32 version;              // SAVE_VERSION
+  u8 game[GAME_STATE_SIZE]; // the game as of the last save, see load_game
+  struct movelog_st log;    // every move of the current run, for replaying it
+};
+
+// the save before it had a version, which load_savecopy carries over
+struct save_v0_st {
+  u32 checksum;
+  u32 books;
+  u32 seed;
+  u32 min;
+  u32 sec;
+  u32 cycles;
+  u8 cheated;
+  u8 songvol;
+  u8 sfxvol;
+  u8 brightness;
+  struct {
+    struct rnd_st rnd;
+    u32 totalexp;
+    i8 selx;
+    i8 sely;
+    u8 difficulty;
+    u8 level;
+    u8 hp;
+    u8 exp;
+    u8 win;
+    struct {
+      i8 size;
+      u8 x[4];
+      u8 y[4];
+    } mummy;
+    u8 losthp;
+    i8 notes[BOARD_SIZE];
+    u8 board[BOARD_SIZE];
+  } game;
 };
 
 static u32 g_down;
@@ -108,9 +145,16 @@ static bool g_time = false;
 static bool g_peek = false;
 static bool g_cheat = false;
 
-struct save_st saveroot;
-static struct game_st *const game = &saveroot.game;
+struct save_st saveroot SECTION_EWRAM;
+static struct game_st g_game;
+static struct game_st *const game = &g_game;
 struct save_st savecopy SECTION_EWRAM;
+static u32 g_forced[BOARD_SIZE] SECTION_EWRAM; // risk-free moves queued for the auto-play
+static i32 g_forced_head = 0;
+static i32 g_forced_size = 0;
+// game_hint for the auto-play, done a slice at a time so it doesn't drop frames
+#define HINT_BUDGET  32 // cells of work per frame
+static struct hint_job_st g_hint_job SECTION_EWRAM;
 struct rnd_st g_rnd = { 1, 1 };
 static bool g_showing_levelup;
 static const struct {
@@ -375,6 +419,7 @@ static void SECTION_IWRAM_ARM irq_vblank() {
     }
   }
   if (g_time && saveroot.min < 1000) {
+    saveroot.log.frames++;
     saveroot.cycles += 280896;
     if (saveroot.cycles >= (1 << 24)) {
       saveroot.cycles -= 1 << 24;
@@ -387,30 +432,77 @@ static void SECTION_IWRAM_ARM irq_vblank() {
   }
 }
 
-static u32 calculate_checksum(struct save_st *g) {
-  u32 old_checksum = g->checksum;
-  g->checksum = 0;
+// every save starts with its checksum, which is left out of the sum
+static u32 calculate_checksum(void *data, u32 size) {
+  u32 *g = data;
+  u32 old_checksum = *g;
+  *g = 0;
   u32 checksum = 123;
-  const u8 *d = (const u8 *)g;
-  for (i32 i = 0; i < sizeof(struct save_st); i++, d++) {
+  const u8 *d = data;
+  for (i32 i = 0; i < size; i++, d++) {
     checksum = whisky2(checksum, *d);
   }
-  g->checksum = old_checksum;
+  *g = old_checksum;
   return checksum;
 }
 
 static void load_savecopy() {
   save_read(&savecopy, sizeof(struct save_st));
+  if (
+    savecopy.checksum == calculate_checksum(&savecopy, sizeof(struct save_st)) &&
+    savecopy.version == SAVE_VERSION
+  ) {
+    return;
+  }
+  // carry an older save over, since it holds the player's books and settings
+  static struct save_v0_st old SECTION_EWRAM;
+  memcpy8(&old, &savecopy, sizeof(struct save_v0_st));
+  if (old.checksum != calculate_checksum(&old, sizeof(struct save_v0_st))) return;
+  memset8(&savecopy, 0, sizeof(struct save_st));
+  savecopy.books = old.books;
+  savecopy.seed = old.seed;
+  savecopy.min = old.min;
+  savecopy.sec = old.sec;
+  savecopy.cycles = old.cycles;
+  savecopy.cheated = old.cheated;
+  savecopy.songvol = old.songvol;
+  savecopy.sfxvol = old.sfxvol;
+  savecopy.brightness = old.brightness;
+  savecopy.version = SAVE_VERSION;
+  // the game's fields are the same but for version, which is 0 for the shuffle old saves used
+  struct game_st *g = (struct game_st *)savecopy.game;
+  g->rnd = old.game.rnd;
+  g->totalexp = old.game.totalexp;
+  g->selx = old.game.selx;
+  g->sely = old.game.sely;
+  g->difficulty = old.game.difficulty;
+  g->version = 0;
+  g->level = old.game.level;
+  g->hp = old.game.hp;
+  g->exp = old.game.exp;
+  g->win = old.game.win;
+  g->mummy.size = old.game.mummy.size;
+  memcpy8(g->mummy.x, old.game.mummy.x, sizeof(g->mummy.x));
+  memcpy8(g->mummy.y, old.game.mummy.y, sizeof(g->mummy.y));
+  g->losthp = old.game.losthp;
+  memcpy8(g->notes, old.game.notes, BOARD_SIZE);
+  memcpy8(g->board, old.game.board, BOARD_SIZE);
+  // the moves so far weren't recorded, so the run can't be replayed
+  movelog_start(&savecopy.log, old.game.difficulty, old.seed);
+  savecopy.log.full = 1;
+  savecopy.checksum = calculate_checksum(&savecopy, sizeof(struct save_st));
 }
 
 static inline void save_savecopy(bool del) {
   if (!del) {
+    saveroot.version = SAVE_VERSION;
+    memcpy8(saveroot.game, game, GAME_STATE_SIZE);
     memcpy8(&savecopy, &saveroot, sizeof(struct save_st));
   }
-  savecopy.checksum = calculate_checksum(&savecopy);
+  savecopy.checksum = calculate_checksum(&savecopy, sizeof(struct save_st));
   if (del) {
     // if deleting, corrupt the checksum
-    savecopy.game.win = 2;
+    savecopy.game[offsetof(struct game_st, win)] = 2;
     savecopy.checksum ^= 0xaa55a5a5;
   }
   save_write(&savecopy, sizeof(struct save_st));
@@ -443,6 +535,8 @@ static void play_song(enum song_enum song, bool restart) {
 }
 
 static void nextframe() {
+  // draw the tiles the game changed since the last frame
+  game_flush(game, handler);
   for (int i = 0; i < 128; i++)
     ani_step(i);
   sys_nextframe();
@@ -685,7 +779,7 @@ static void place_floor(i32 x, i32 y, i32 state) {
 
 static void place_threat(i32 x, i32 y) {
   if (x < 0 || x >= BOARD_W || y < 0 || y >= BOARD_H) return;
-  i32 threat = count_threat(game->board, x, y);
+  i32 threat = game_count_threat(game, x, y);
   if (game->difficulty & D_ONLYMINES) {
     threat >>= 8;
     place_number(x, y, 0, threat == 0 ? -3 : threat);
@@ -918,12 +1012,32 @@ static void load_level(i32 diff, u32 seed) {
   u32 group = seed & (GENERATE_SIZE - 1);
   sys_print("new game seed: %x, group: %x, diff: %x", seed, group, diff);
   const u8 *levels = BINADDR(levels_bin);
-  levels += group * 128 * 6;
+  levels += group * GROUP_STRIDE;
   if (diff & D_ONLYMINES) {
-    game_new(game, diff, seed, levels + 128 * 5);
+    game_new(game, diff, seed, levels + LEVEL_STRIDE * 5);
+    movelog_start(&saveroot.log, diff, seed);
   } else {
-    game_new(game, diff, seed, levels + 128 * diff);
+    game_new(game, diff | D_VERSION1, seed, levels + LEVEL_STRIDE * diff);
+    movelog_start(&saveroot.log, diff | D_VERSION1, seed);
+  }
+  game->batch = true;
+  g_forced_head = 0;
+  g_forced_size = 0;
+  game_hint_cancel(&g_hint_job);
+}
+
+// pick up the saved game where it left off, rebuilding the caches the save leaves out
+static void load_game() {
+  memcpy8(game, saveroot.game, GAME_STATE_SIZE);
+  for (i32 y = 0; y < BOARD_H; y++) {
+    game->dirty[y] = 0;
   }
+  game->batch = true;
+  game->journal = NULL;
+  game_sync(game);
+  g_forced_head = 0;
+  g_forced_size = 0;
+  game_hint_cancel(&g_hint_job);
 }
 
 static void load_tutorial() {
@@ -946,6 +1060,31 @@ static void load_tutorial() {
   for (i32 i = 0; i < BOARD_SIZE; i++) {
     game->board[i] = board[i];
   }
+  game_sync(game);
+  saveroot.log.full = 1; // the stomped board can't be replayed
+}
+
+// every move goes through these, so it's in the move log
+static void play_hover(i32 x, i32 y) {
+  if (GET_TYPEXY(game->board, x, y) == T_LAVA) {
+    movelog_add(&saveroot.log, H_HOVER(x, y));
+  }
+  game_hover(game, handler, x, y);
+}
+
+static bool play_click() {
+  movelog_add(&saveroot.log, H_CLICK(game->selx, game->sely));
+  return game_click(game, handler);
+}
+
+static void play_note(i8 note) {
+  movelog_add(&saveroot.log, H_NOTE(game->selx, game->sely, note));
+  game_note(game, handler, note);
+}
+
+static bool play_levelup() {
+  movelog_add(&saveroot.log, H_LEVELUP());
+  return game_levelup(game, handler);
 }
 
 static void load_scr_raw(const void *addr, u32 size, bool showobj) {
@@ -1130,7 +1269,7 @@ static void exp_update(i32 cur, i32 max) {
 }
 
 static void you_lose(i32 x, i32 y) {
-  if (!(saveroot.game.difficulty & D_ONLYMINES)) {
+  if (!(game->difficulty & D_ONLYMINES)) {
     sfx_youdie();
   }
   g_time = false;
@@ -1209,10 +1348,10 @@ static void draw_time_seed(bool classic) {
 
   // "SEED"
   PUSH(ani_statsseed, 30);
-  { // difficulty
-    i32 d = (saveroot.game.difficulty & D_ONLYMINES)
-      ? 10 + (saveroot.game.difficulty ^ D_ONLYMINES)
-      : saveroot.game.difficulty;
+  { // difficulty: 0-4 legacy shuffle, 5-9 single pass shuffle, 10-14 only mines
+    i32 d = (game->difficulty & D_ONLYMINES)
+      ? 10 + (game->difficulty ^ D_ONLYMINES)
+      : game->difficulty + (game->version ? 5 : 0);
     PUSH(ani_statsX[d], 6);
   }
   for (u32 i = 0, seed = saveroot.seed; i < 8; i++, seed <<= 4) {
@@ -1333,8 +1472,8 @@ static void handler(struct game_st *game, enum game_event ev, i32 x, i32 y) {
       }
       if (x >= SFX_GRUNT1 && x <= SFX_GRUNT7) {
         g_sprites[S_POPUPCUR].pc = ani_slash;
-        g_sprites[S_POPUPCUR].origin.x = saveroot.game.selx * 16 + 8;
-        g_sprites[S_POPUPCUR].origin.y = saveroot.game.sely * 16 + 3;
+        g_sprites[S_POPUPCUR].origin.x = game->selx * 16 + 8;
+        g_sprites[S_POPUPCUR].origin.y = game->sely * 16 + 3;
       }
       break;
     case EV_DEBUGLOG:    sys_print("[%x] value %x", x, y); break;
@@ -1908,14 +2047,17 @@ static i32 title_screen() { // -1 = continue, 0-0xff = new game difficulty, 0x10
   load_scr(scr_title_o);
 
   load_savecopy();
-  u32 cs = calculate_checksum(&savecopy);
+  u32 cs = calculate_checksum(&savecopy, sizeof(struct save_st));
   bool valid_save = savecopy.checksum == cs;
-  bool has_file = valid_save && savecopy.game.win == 0;
+  bool has_file = valid_save && savecopy.game[offsetof(struct game_st, win)] == 0;
   if (valid_save) {
     memcpy8(&saveroot, &savecopy, sizeof(struct save_st));
     snd_set_song_volume(saveroot.songvol);
     snd_set_sfx_volume(saveroot.sfxvol);
   }
+  if (has_file) {
+    load_game();
+  }
 
   palette_fadefromwhite();
 
@@ -1984,7 +2126,7 @@ static i32 title_screen() { // -1 = continue, 0-0xff = new game difficulty, 0x10
           // delete!
           save_savecopy(true);
           saveroot.books = RESET_BOOKS;
-          saveroot.game.win = 3;
+          game->win = 3;
           valid_save = false;
           g_cheat = false;
           menu = 0;
@@ -2046,9 +2188,7 @@ static void move_game_cursor(i32 dx, i32 dy) {
   nextframe();
   i32 nx = game->selx + dx;
   i32 ny = game->sely + dy;
-  game_hover(
-    game,
-    handler,
+  play_hover(
     nx < 0 ? BOARD_W - 1 : nx >= BOARD_W ? 0 : nx,
     ny < 0 ? BOARD_H - 1 : ny >= BOARD_H ? 0 : ny
   );
@@ -2068,7 +2208,7 @@ static inline u8 spix(i32 x, i32 y) {
 void gvmain() {
   sys_init();
   saveroot.books = RESET_BOOKS;
-  saveroot.game.win = 3;
+  game->win = 3;
   saveroot.brightness = 2;
   saveroot.songvol = 6;
   saveroot.sfxvol = 16;
@@ -2289,9 +2429,31 @@ start_game:
         } else {
           // let the computer play
           saveroot.cheated = 1;
-          hint_cooldown = hint_cooldown_max;
-          if (hint_cooldown_max > 0) hint_cooldown_max--;
-          i32 hint = game_hint(game, handler, -1);
+          // play queued risk-free moves first, and only ask for a hint when they run out
+          if (g_forced_head >= g_forced_size) {
+            g_forced_head = 0;
+            g_forced_size = game_forced(game, g_forced, BOARD_SIZE);
+          }
+          while (
+            g_forced_head < g_forced_size &&
+            !game_forced_valid(game, g_forced[g_forced_head])
+          ) {
+            g_forced_head++;
+          }
+          i32 hint = -1;
+          if (g_forced_head < g_forced_size) {
+            hint = g_forced[g_forced_head++];
+          } else if (game_hint_step(game, handler, &g_hint_job, HINT_BUDGET)) {
+            hint = g_hint_job.result;
+            // game_hint breaks ties with the game's rnd, which the move log can't reproduce
+            saveroot.log.full = 1;
+          }
+          if (hint != -1) {
+            hint_cooldown = hint_cooldown_max;
+            if (hint_cooldown_max > 0) hint_cooldown_max--;
+          }
+          // otherwise the hint isn't worked out yet, so keep at it next frame; -1 isn't any of the
+          // actions below
           u8 x = hint & 0xff;
           u8 y = (hint >> 8) & 0xff;
           u8 action = (hint >> 16) & 0xff;
@@ -2299,26 +2461,26 @@ start_game:
           //sys_print("hint: %x %x %x %x", x, y, action, note);
           switch (action) {
             case 0: // click
-              game_hover(game, handler, x, y);
+              play_hover(x, y);
               cursor_to_gamesel();
-              if (!game_click(game, handler)) {
+              if (!play_click()) {
                 sfx_bump();
               }
               break;
             case 1: { // note
-              game_hover(game, handler, x, y);
+              play_hover(x, y);
               cursor_to_gamesel();
-              game_note(game, handler, note);
+              play_note(note);
               break;
             }
             case 2: // levelup
-              if (!game_levelup(game, handler)) {
+              if (!play_levelup()) {
                 sfx_bump();
               } else {
                 sfx_levelup();
               }
               break;
-            default:
+            case 3: // give up
               sfx_bump();
               hint_cooldown = hint_cooldown_max = 30;
               break;
@@ -2343,7 +2505,7 @@ start_game:
         if (tutorial) {
           if (!tut_cooldown) {
             if (TU_GETZ(tutorial_steps[tutstep].wait) == 4) { // TU_WAIT_SE
-              if (game_levelup(game, handler)) {
+              if (play_levelup()) {
                 levelup_cooldown = 45;
                 sfx_levelup();
                 tutnext = true;
@@ -2355,7 +2517,7 @@ start_game:
             }
           }
         } else if (!(game->difficulty & D_ONLYMINES) && !levelup_cooldown) {
-          if (game_levelup(game, handler)) {
+          if (play_levelup()) {
             levelup_cooldown = 45;
             sfx_levelup();
           } else {
@@ -2396,7 +2558,7 @@ start_game:
                   (TU_GETZ(tutorial_steps[tutstep].wait) == 3 && v == 2)
                 ) {
                   sfx_accept();
-                  game_note(game, handler, v);
+                  play_note(v);
                   tutnext = true;
                 } else {
                   sfx_bump();
@@ -2406,7 +2568,7 @@ start_game:
                 }
               } else {
                 sfx_accept();
-                game_note(game, handler, v);
+                play_note(v);
               }
             } else if (tutorial) {
               // restore tutorial popup
@@ -2429,13 +2591,13 @@ start_game:
               TU_GETX(tutorial_steps[tutstep].arrow) == game->selx &&
               TU_GETY(tutorial_steps[tutstep].arrow) == game->sely
             ) {
-              game_click(game, handler);
+              play_click();
               tutnext = true;
             } else {
               sfx_bump();
             }
           }
-        } else if (!game_click(game, handler)) {
+        } else if (!play_click()) {
           sfx_bump();
         }
       } else if (g_hit & SYS_INPUT_ST) {
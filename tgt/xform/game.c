@@ -0,0 +1,1833 @@
+//
+// cryptsweeper - fight the graveyard monsters and stop death
+// by Pocket Pulp (@velipso), https://pulp.biz
+// Project Home: https://github.com/velipso/cryptsweeper
+// SPDX-License-Identifier: 0BSD
+//
+
+#include "game.h"
+#include <stddef.h>
+
+// indexed by enum game_type, see struct game_tile_st
+#define TILE(px, py)  (((px) >> 3) + (((py) >> 3) << 5))
+const struct game_tile_st game_tiles[] = {
+  // icon          threat flags       action      grunt       reward        value group
+  {0,              0,     TF_EMPTY,   TA_NONE,    0,          T_EMPTY,      0, {0, 0}}, // T_EMPTY
+  {0,              0,     TF_EMPTY,   TA_NONE,    0,          T_EMPTY,      0, {0, 0}}, // T_LAVA
+  {TILE(112, 16),  1,     TF_MONSTER, TA_MONSTER, SFX_GRUNT4, T_EMPTY,      0, {0, 0}}, // T_LV1A
+  {TILE(112, 32),  1,     TF_MONSTER, TA_MONSTER, SFX_GRUNT5, T_ITEM_SHOW5, 0, {0, 0}}, // T_LV1B
+  {TILE(112, 48),  2,     TF_MONSTER, TA_MONSTER, SFX_GRUNT6, T_EMPTY,      0, {0, 0}}, // T_LV2
+  {TILE(160, 0),   3,     TF_MONSTER, TA_MONSTER, SFX_GRUNT1, T_EMPTY,      0, {0, 0}}, // T_LV3A
+  {TILE(160, 16),  3,     TF_MONSTER, TA_GROUP,   SFX_GRUNT1, T_EMPTY,      0, {T_ITEM_LV3B0, T_ITEM_EXP6}}, // T_LV3B
+  {TILE(160, 32),  3,     TF_MONSTER, TA_GROUP,   SFX_GRUNT1, T_EMPTY,      0, {T_ITEM_LV3C0, T_ITEM_EXP9}}, // T_LV3C
+  {TILE(160, 48),  4,     TF_MONSTER, TA_MONSTER, SFX_GRUNT2, T_EMPTY,      0, {0, 0}}, // T_LV4A
+  {TILE(160, 64),  4,     TF_MONSTER, TA_MONSTER, SFX_GRUNT2, T_EMPTY,      0, {0, 0}}, // T_LV4B
+  {TILE(160, 80),  4,     TF_MONSTER, TA_MONSTER, SFX_GRUNT2, T_EMPTY,      0, {0, 0}}, // T_LV4C
+  {TILE(160, 96),  5,     TF_MONSTER, TA_MONSTER, SFX_GRUNT4, T_EMPTY,      0, {0, 0}}, // T_LV5A
+  {TILE(160, 112), 5,     TF_MONSTER, TA_MONSTER, SFX_GRUNT4, T_ITEM_SHOW1, 0, {0, 0}}, // T_LV5B
+  {TILE(208, 0),   5,     TF_MONSTER, TA_MONSTER, SFX_GRUNT3, T_EMPTY,      0, {0, 0}}, // T_LV5C
+  {TILE(208, 16),  6,     TF_MONSTER, TA_MONSTER, SFX_GRUNT2, T_EMPTY,      0, {0, 0}}, // T_LV6
+  {TILE(208, 32),  7,     TF_MONSTER, TA_MONSTER, SFX_GRUNT2, T_EMPTY,      0, {0, 0}}, // T_LV7
+  {TILE(208, 48),  8,     TF_MONSTER, TA_MONSTER, SFX_GRUNT2, T_EMPTY,      0, {0, 0}}, // T_LV8
+  {TILE(208, 64),  9,     TF_MONSTER, TA_MONSTER, SFX_GRUNT3, T_ITEM_HEAL,  0, {0, 0}}, // T_LV9
+  {TILE(208, 80),  10,    TF_MONSTER, TA_MONSTER, SFX_GRUNT5, T_ITEM_LAVA,  0, {0, 0}}, // T_LV10
+  {TILE(208, 96),  11,    TF_MONSTER, TA_MONSTER, SFX_GRUNT1, T_EMPTY,      0, {0, 0}}, // T_LV11
+  {TILE(208, 112), 13,    TF_MONSTER, TA_MONSTER, SFX_GRUNT7, T_ITEM_EXIT,  0, {0, 0}}, // T_LV13
+  {TILE(64, 16),   0x100, 0,          TA_MINE,    0,          T_EMPTY,      0, {0, 0}}, // T_MINE
+  {TILE(16, 96),   0,     0,          TA_WALL,    0,          T_EMPTY,      0, {0, 0}}, // T_WALL
+  {TILE(208, 96),  0,     TF_CHEST,   TA_CHEST,   0,          T_ITEM_HEAL,  0, {0, 0}}, // T_CHEST_HEAL
+  {TILE(208, 96),  0,     TF_CHEST,   TA_CHEST,   0,          T_ITEM_EYE2,  0, {0, 0}}, // T_CHEST_EYE2
+  {TILE(208, 96),  0,     TF_CHEST,   TA_CHEST,   0,          T_ITEM_EXP5,  0, {0, 0}}, // T_CHEST_EXP
+  {TILE(0, 112),   0,     TF_ITEM,    TA_HEAL,    0,          T_EMPTY,      0, {0, 0}}, // T_ITEM_HEAL
+  {TILE(16, 112),  0,     TF_ITEM,    TA_EYE,     0,          T_EMPTY,      0, {0, 0}}, // T_ITEM_EYE
+  {TILE(16, 112),  0,     TF_ITEM,    TA_EYE2,    0,          T_EMPTY,      0, {0, 0}}, // T_ITEM_EYE2
+  {TILE(32, 112),  0,     TF_ITEM,    TA_SHOW1,   0,          T_EMPTY,      0, {0, 0}}, // T_ITEM_SHOW1
+  {TILE(48, 112),  0,     TF_ITEM,    TA_SHOW5,   0,          T_EMPTY,      0, {0, 0}}, // T_ITEM_SHOW5
+  {TILE(64, 112),  0,     TF_ITEM,    TA_EXP,     0,          T_EMPTY,      1, {0, 0}}, // T_ITEM_EXP1
+  {TILE(80, 112),  0,     TF_ITEM,    TA_EXP,     0,          T_EMPTY,      3, {0, 0}}, // T_ITEM_EXP3
+  {TILE(96, 112),  0,     TF_ITEM,    TA_EXP,     0,          T_EMPTY,      5, {0, 0}}, // T_ITEM_EXP5
+  {TILE(112, 112), 0,     TF_ITEM,    TA_EXP,     0,          T_EMPTY,      6, {0, 0}}, // T_ITEM_EXP6
+  {TILE(128, 112), 0,     TF_ITEM,    TA_EXP,     0,          T_EMPTY,      9, {0, 0}}, // T_ITEM_EXP9
+  {TILE(192, 16),  0,     TF_ITEM,    TA_REJECT,  0,          T_EMPTY,      0, {0, 0}}, // T_ITEM_LV3B0
+  {TILE(192, 32),  0,     TF_ITEM,    TA_REJECT,  0,          T_EMPTY,      0, {0, 0}}, // T_ITEM_LV3C0
+  {TILE(144, 112), 0,     TF_ITEM,    TA_LAVA,    0,          T_EMPTY,      0, {0, 0}}, // T_ITEM_LAVA
+  {TILE(0, 96),    0,     TF_ITEM,    TA_EXIT,    0,          T_EMPTY,      0, {0, 0}}  // T_ITEM_EXIT
+};
+#undef TILE
+_Static_assert(sizeof(game_tiles) / sizeof(game_tiles[0]) == T__SIZE, "game_tiles is missing a type");
+_Static_assert(T__SIZE <= 64, "tile types must fit in 6 bits");
+
+static i32 tile_collect(struct game_st *game, game_handler_f handler, u32 type);
+static void tile_changed(struct game_st *game, game_handler_f handler, i32 x, i32 y);
+static i32 tile_attack(struct game_st *game, game_handler_f handler, u32 type);
+
+// bits (x - w) through (x + w) of a row, shifted down to bit 0, off-board columns read as 0
+static inline u32 row_window(bitrow row, i32 x, i32 w) {
+  u32 r = x >= w ? (u32)(row >> (x - w)) : (u32)row << (w - x);
+  return r & ((1 << (w * 2 + 1)) - 1);
+}
+
+// the 8 neighbors of (x, y) packed into 9 bits, center is always 0
+static inline u32 plane_neighbors(const bitrow *plane, i32 x, i32 y) {
+  u32 r = (row_window(plane[y], x, 1) & 5) << 3;
+  if (y > 0) r |= row_window(plane[y - 1], x, 1);
+  if (y < BOARD_H - 1) r |= row_window(plane[y + 1], x, 1) << 6;
+  return r;
+}
+
+// set the 3x3 box around (x, y)
+static inline void plane_box(bitrow *plane, i32 x, i32 y) {
+  bitrow mask = (ROW_BIT(x) | (ROW_BIT(x) << 1) | (ROW_BIT(x) >> 1)) & ROW_MASK;
+  for (i32 by = y > 0 ? y - 1 : 0; by <= y + 1 && by < BOARD_H; by++) {
+    plane[by] |= mask;
+  }
+}
+
+// which planes a board byte belongs to (excluding P_NOTED)
+static u32 tile_planes(u8 b) {
+  u32 t = GET_TYPE(b);
+  u32 m = 1 << GET_STATUS(b);
+  if (IS_EMPTY(b)) {
+    m |= 1 << P_EMPTY;
+  } else if (IS_MONSTER(b)) {
+    m |= (1 << P_MONSTER) | (game_tiles[t].threat << P_LEVEL1);
+    if (t == T_LV5C) m |= 1 << P_LV5C;
+  } else if (t == T_MINE) {
+    m |= 1 << P_MINE;
+  } else if (t == T_WALL) {
+    m |= 1 << P_WALL;
+  } else if (IS_CHEST(b)) {
+    m |= 1 << P_CHEST;
+  }
+  return m;
+}
+
+void planes_build(bitplane *planes, const u8 *board) {
+  for (i32 p = 0; p < P__SIZE; p++) {
+    for (i32 y = 0; y < BOARD_H; y++) {
+      planes[p][y] = 0;
+    }
+  }
+  for (i32 y = 0, k = 0; y < BOARD_H; y++) {
+    for (i32 x = 0; x < BOARD_W; x++, k++) {
+      u32 m = tile_planes(board[k]);
+      for (i32 p = 0; m; p++, m >>= 1) {
+        if (m & 1) planes[p][y] |= ROW_BIT(x);
+      }
+    }
+  }
+}
+
+// counts set bits around (x, y), same `rad` rules as the generator: square of radius `rad`, or
+// diamond of radius `-rad` if negative
+i32 plane_count(const bitrow *plane, i32 x, i32 y, i32 rad) {
+  i32 result = 0;
+  bool diamond = false;
+  i32 w = rad;
+  if (rad < 0) {
+    diamond = true;
+    rad = -rad;
+    w = 0;
+  }
+  for (i32 dy = -rad; dy <= rad; dy++) {
+    i32 by = dy + y;
+    if (by >= 0 && by < BOARD_H && x + w >= 0 && x - w < BOARD_W) {
+      result += popcount(row_window(plane[by], x, w));
+    }
+    if (diamond) {
+      if (dy < 0) w++;
+      else w--;
+    }
+  }
+  return result;
+}
+
+// recalculate the cells in range of a lv5c, which is a diamond of radius 2
+static void update_witched(struct game_st *game) {
+  const bitrow *w = game->planes[P_LV5C];
+  for (i32 y = 0; y < BOARD_H; y++) {
+    bitrow r = w[y] | (w[y] << 1) | (w[y] >> 1) | (w[y] << 2) | (w[y] >> 2);
+    if (y > 0) r |= w[y - 1] | (w[y - 1] << 1) | (w[y - 1] >> 1);
+    if (y < BOARD_H - 1) r |= w[y + 1] | (w[y + 1] << 1) | (w[y + 1] >> 1);
+    if (y > 1) r |= w[y - 2];
+    if (y < BOARD_H - 2) r |= w[y + 2];
+    game->witched[y] = r & ROW_MASK;
+  }
+}
+
+// zobrist keys are derived from whisky2 instead of stored, so the GBA doesn't need a table
+enum zobrist_kind {
+  Z_BOARD = 0x10000, // | cell index
+  Z_NOTE  = 0x20000, // | cell index
+  Z_HP    = 0x30000,
+  Z_EXP   = 0x40000,
+  Z_LEVEL = 0x50000
+};
+
+static inline u64 zkey(u32 kind, u32 value) {
+  u32 a = whisky2(kind, value);
+  return ((u64)a << 32) | whisky2(a, kind ^ value);
+}
+
+u64 game_zobrist(const struct game_st *game) {
+  u64 hash = zkey(Z_HP, game->hp) ^ zkey(Z_EXP, game->exp) ^ zkey(Z_LEVEL, game->level);
+  for (i32 k = 0; k < BOARD_SIZE; k++) {
+    hash ^= zkey(Z_BOARD | k, game->board[k]) ^ zkey(Z_NOTE | k, (u8)game->notes[k]);
+  }
+  return hash;
+}
+
+void game_sync(struct game_st *game) {
+  planes_build(game->planes, game->board);
+  const bitplane *p = game->planes;
+  for (i32 y = 0, k = 0; y < BOARD_H; y++) {
+    for (i32 x = 0; x < BOARD_W; x++, k++) {
+      if (game->notes[k] != -3) {
+        game->planes[P_NOTED][y] |= ROW_BIT(x);
+      }
+      game->threat[k] =
+        popcount(plane_neighbors(p[P_LEVEL1], x, y)) +
+        popcount(plane_neighbors(p[P_LEVEL2], x, y)) * 2 +
+        popcount(plane_neighbors(p[P_LEVEL4], x, y)) * 4 +
+        popcount(plane_neighbors(p[P_LEVEL8], x, y)) * 8 +
+        popcount(plane_neighbors(p[P_MINE], x, y)) * 0x100;
+    }
+  }
+  update_witched(game);
+  game->hash = game_zobrist(game);
+  for (i32 y = 0; y < BOARD_H; y++) {
+    game->solver.stale[y] = ROW_MASK;
+    game->solver.stale_could[y] = ROW_MASK;
+  }
+}
+
+// threat a tile contributes to its neighbors, from its plane mask
+static inline i32 planes_threat(u32 m) {
+  return ((m >> P_LEVEL1) & 15) + ((m & (1 << P_MINE)) ? 0x100 : 0);
+}
+
+static void journal_push(struct journal_st *j, u32 entry) {
+  if (j->lost) return;
+  while (j->used >= JOURNAL_SIZE) {
+    // forget the oldest action, which starts at the tail
+    j->used--;
+    while (j->used && j->entries[(j->head - j->used) & (JOURNAL_SIZE - 1)] != JOURNAL_MARK) {
+      j->used--;
+    }
+    if (j->used == 0) {
+      // the action in progress was the oldest, and it's too big to keep
+      j->lost = 1;
+      j->actions = 0;
+      return;
+    }
+    j->actions--;
+  }
+  j->entries[j->head] = entry;
+  j->head = (j->head + 1) & (JOURNAL_SIZE - 1);
+  j->used++;
+}
+
+static inline void journal_byte(struct game_st *game, size_t offset, u8 old) {
+  struct journal_st *j = game->journal;
+  if (j && j->depth) {
+    journal_push(j, ((u32)offset << 8) | old);
+  }
+}
+
+static void journal_begin(struct game_st *game) {
+  struct journal_st *j = game->journal;
+  if (!j || j->depth++) return;
+  const u8 *now = (const u8 *)game;
+  for (size_t i = 0; i < JOURNAL_HEAD; i++) {
+    j->start[i] = now[i];
+  }
+  j->lost = 0;
+  journal_push(j, JOURNAL_MARK);
+}
+
+static void journal_end(struct game_st *game) {
+  struct journal_st *j = game->journal;
+  if (!j || --j->depth) return;
+  const u8 *now = (const u8 *)game;
+  for (size_t i = 0; i < JOURNAL_HEAD; i++) {
+    if (now[i] != j->start[i]) {
+      journal_push(j, (i << 8) | j->start[i]);
+    }
+  }
+  if (j->lost) return;
+  if (j->entries[(j->head - 1) & (JOURNAL_SIZE - 1)] == JOURNAL_MARK) {
+    // nothing changed, so there's nothing to undo
+    j->head = (j->head - 1) & (JOURNAL_SIZE - 1);
+    j->used--;
+  } else {
+    j->actions++;
+  }
+}
+
+// all board writes go through here to keep the bitplanes and threat cache in sync
+static void set_tile(struct game_st *game, i32 x, i32 y, u8 b) {
+  i32 k = x + y * BOARD_W;
+  if (game->board[k] != b) {
+    journal_byte(game, offsetof(struct game_st, board) + k, game->board[k]);
+  }
+  u32 m0 = tile_planes(game->board[k]);
+  u32 m1 = tile_planes(b);
+  u32 diff = m0 ^ m1;
+  game->hash ^= zkey(Z_BOARD | k, game->board[k]) ^ zkey(Z_BOARD | k, b);
+  game->board[k] = b;
+  if (!diff) return;
+  for (i32 p = 0, d = diff; d; p++, d >>= 1) {
+    if (d & 1) game->planes[p][y] ^= ROW_BIT(x);
+  }
+  // neighbors know something new about this cell, and it might have become a pressed empty cell
+  plane_box(game->solver.stale, x, y);
+  plane_box(game->solver.stale_could, x, y);
+  i32 delta = planes_threat(m1) - planes_threat(m0);
+  if (delta) {
+    for (i32 by = y - 1; by <= y + 1; by++) {
+      if (by < 0 || by >= BOARD_H) continue;
+      for (i32 bx = x - 1; bx <= x + 1; bx++) {
+        if (bx < 0 || bx >= BOARD_W || (bx == x && by == y)) continue;
+        game->threat[bx + by * BOARD_W] += delta;
+      }
+    }
+  }
+  if (diff & (1 << P_LV5C)) {
+    bitplane old;
+    for (i32 by = 0; by < BOARD_H; by++) {
+      old[by] = game->witched[by];
+    }
+    update_witched(game);
+    for (i32 by = 0; by < BOARD_H; by++) {
+      game->solver.stale[by] |= old[by] ^ game->witched[by];
+    }
+  }
+}
+
+static inline void set_type(struct game_st *game, i32 x, i32 y, u32 t) {
+  u8 b = game->board[x + y * BOARD_W];
+  SET_TYPE(b, t);
+  set_tile(game, x, y, b);
+}
+
+static inline void set_status(struct game_st *game, i32 x, i32 y, u32 s) {
+  u8 b = game->board[x + y * BOARD_W];
+  SET_STATUS(b, s);
+  set_tile(game, x, y, b);
+}
+
+static void set_note(struct game_st *game, i32 x, i32 y, i8 note) {
+  i32 k = x + y * BOARD_W;
+  if (game->notes[k] != note) {
+    journal_byte(game, offsetof(struct game_st, notes) + k, game->notes[k]);
+  }
+  game->hash ^= zkey(Z_NOTE | k, (u8)game->notes[k]) ^ zkey(Z_NOTE | k, (u8)note);
+  game->notes[k] = note;
+  plane_box(game->solver.stale, x, y);
+  if (note == -3) {
+    game->planes[P_NOTED][y] &= ~ROW_BIT(x);
+  } else {
+    game->planes[P_NOTED][y] |= ROW_BIT(x);
+  }
+}
+
+void game_swap(struct game_st *game, i32 a, i32 b) {
+  u8 ta = game->board[a];
+  u8 tb = game->board[b];
+  set_tile(game, a % BOARD_W, a / BOARD_W, tb);
+  set_tile(game, b % BOARD_W, b / BOARD_W, ta);
+}
+
+// hp, exp and level changes after game_new go through these to keep the hash up to date
+static void set_hp(struct game_st *game, i32 hp) {
+  game->hash ^= zkey(Z_HP, game->hp) ^ zkey(Z_HP, (u8)hp);
+  game->hp = hp;
+}
+
+static void set_exp(struct game_st *game, i32 exp) {
+  game->hash ^= zkey(Z_EXP, game->exp) ^ zkey(Z_EXP, (u8)exp);
+  game->exp = exp;
+}
+
+static void set_level(struct game_st *game, i32 level) {
+  game->hash ^= zkey(Z_LEVEL, game->level) ^ zkey(Z_LEVEL, (u8)level);
+  game->level = level;
+}
+
+void game_new(struct game_st *game, i32 difficulty, u32 seed, const u8 *board) {
+  rnd_seed(&game->rnd, seed);
+  game->version = (difficulty & D_VERSION1) ? 1 : 0;
+  difficulty &= ~D_VERSION1;
+  game->level = 0;
+  game->hp = 0;
+  game->totalexp = 0;
+  game->exp = 0;
+  game->difficulty = difficulty;
+  game->win = 0;
+  game->hp = max_hp(game);
+  game->mummy.size = 0;
+  game->losthp = 0;
+  game->selx = BOARD_CW;
+  game->sely = BOARD_CH;
+  game->batch = false;
+  game->journal = NULL;
+  for (i32 y = 0; y < BOARD_H; y++) {
+    game->dirty[y] = 0;
+  }
+
+  if (difficulty & D_ONLYMINES) {
+    // copy onlymines level based on difficulty
+    difficulty &= ~D_ONLYMINES;
+    for (i32 i = 0; i < BOARD_SIZE; i++) {
+      game->notes[i] = -3;
+      game->board[i] = (board[i] & (1 << difficulty)) ? T_MINE : T_EMPTY;
+    }
+    game_sync(game);
+    // find the best location for the start by looking for the most empty cells
+    i32 best_score = -1;
+    i32 same_score = 0;
+    for (i32 y = 0, i = 0; y < BOARD_H; y++) {
+      for (i32 x = 0; x < BOARD_W; x++, i++) {
+        if (IS_EMPTY(game->board[i])) {
+          i32 score = plane_count(game->planes[P_EMPTY], x, y, 1);
+          if (score > best_score) {
+            best_score = score;
+            same_score = 1;
+            game->selx = x;
+            game->sely = y;
+          } else if (score == best_score && rnd_pick(&game->rnd, same_score)) {
+            same_score++;
+            game->selx = x;
+            game->sely = y;
+          }
+        }
+      }
+    }
+  } else {
+    // copy normal level
+    for (i32 y = 0, i = 0; y < BOARD_H; y++) {
+      for (i32 x = 0; x < BOARD_W; x++, i++) {
+        game->notes[i] = -3;
+        game->board[i] = board[i];
+        // start at the T_ITEM_EYE
+        if (GET_TYPE(game->board[i]) == T_ITEM_EYE) {
+          game->selx = x;
+          game->sely = y;
+        }
+      }
+    }
+    // swap some empty/lv1a/lv2 around for fun
+    if (game->version) {
+      // one Fisher-Yates pass over the eligible cells
+      u8 cells[BOARD_SIZE];
+      u8 tiles[BOARD_SIZE];
+      i32 count = 0;
+      for (i32 i = 0; i < BOARD_SIZE; i++) {
+        i32 t = GET_TYPE(game->board[i]);
+        if (IS_EMPTY(t) || t == T_LV1A || t == T_LV2) {
+          cells[count] = i;
+          tiles[count] = game->board[i];
+          count++;
+        }
+      }
+      if (count > 1) {
+        shuffle8(&game->rnd, tiles, count);
+      }
+      for (i32 i = 0; i < count; i++) {
+        game->board[cells[i]] = tiles[i];
+      }
+    } else {
+      // legacy: 300 rounds of random swaps
+      for (i32 swap = 0; swap < 300; swap++) {
+        i32 ai = 0, ap = 0;
+        i32 bi = 0, bp = 0;
+        for (i32 i = 0; i < BOARD_SIZE; i++) {
+          i32 t = GET_TYPE(game->board[i]);
+          if (IS_EMPTY(t) || t == T_LV1A || t == T_LV2) {
+            if (roll(&game->rnd, 2)) {
+              // give `a` first crack at it
+              if (rnd_pick(&game->rnd, ap++)) ai = i;
+              else if (rnd_pick(&game->rnd, bp++)) bi = i;
+            } else {
+              // give `b` first crack at it
+              if (rnd_pick(&game->rnd, bp++)) bi = i;
+              else if (rnd_pick(&game->rnd, ap++)) ai = i;
+            }
+          }
+        }
+        if (ap > 0 && bp > 0) {
+          i32 temp = game->board[ai];
+          game->board[ai] = game->board[bi];
+          game->board[bi] = temp;
+        }
+      }
+    }
+    game_sync(game);
+  }
+}
+
+static i32 you_died(struct game_st *game, game_handler_f handler);
+void game_hover(struct game_st *game, game_handler_f handler, i32 x, i32 y) {
+  journal_begin(game);
+  game->selx = x;
+  game->sely = y;
+  // hovering over lava?
+  if (GET_TYPEXY(game->board, x, y) == T_LAVA) {
+    handler(game, EV_HOVER_LAVA, x, y);
+    if (game->hp == 0) {
+      you_died(game, handler);
+    } else {
+      set_hp(game, game->hp - 1);
+      handler(game, EV_HP_UPDATE, game->hp, max_hp(game));
+    }
+  }
+  journal_end(game);
+}
+
+static void check_onlymines(struct game_st *game, game_handler_f handler) {
+  // flood fill one wave at a time, where each wave is a bitplane so it's revealed in row order,
+  // and only the opened cells are visited
+  bitplane seen;
+  bitplane wave;
+  for (i32 y = 0; y < BOARD_H; y++) {
+    seen[y] = 0;
+    wave[y] = 0;
+  }
+  i32 selx = game->selx;
+  i32 sely = game->sely;
+  PLANE_SET(seen, selx, sely);
+  PLANE_SET(wave, selx, sely);
+  for (;;) {
+    bitplane next;
+    for (i32 y = 0; y < BOARD_H; y++) {
+      next[y] = 0;
+    }
+    for (i32 y = 0; y < BOARD_H; y++) {
+      for (bitrow row = wave[y]; row; row &= row - 1) {
+        i32 x = row_ctz(row);
+        i32 k = x + y * BOARD_W;
+        if (IS_EMPTY(game->board[k]) && game_count_threat(game, x, y) == 0) {
+          // open the neighbors in the next wave
+          bitrow mask = (ROW_BIT(x) | (ROW_BIT(x) << 1) | (ROW_BIT(x) >> 1)) & ROW_MASK;
+          for (i32 by = y > 0 ? y - 1 : 0; by <= y + 1 && by < BOARD_H; by++) {
+            next[by] |= mask & ~seen[by];
+          }
+        }
+        game->selx = x;
+        game->sely = y;
+        set_status(game, x, y, S_PRESSED);
+        tile_attack(game, handler, game->board[k]);
+        tile_changed(game, handler, x, y);
+      }
+    }
+    bool found = false;
+    for (i32 y = 0; y < BOARD_H; y++) {
+      found = found || next[y];
+      seen[y] |= next[y];
+      wave[y] = next[y];
+    }
+    if (!found) break;
+    handler(game, EV_WAIT, 1, 0);
+  }
+  game->selx = selx;
+  game->sely = sely;
+
+  // check if we won
+  if (!game->win) {
+    // won if there are no hidden empty tiles left
+    bool won = true;
+    for (i32 y = 0; y < BOARD_H && won; y++) {
+      won = !(game->planes[P_HIDDEN][y] & game->planes[P_EMPTY][y]);
+    }
+    if (won) {
+      game->win = 2;
+      handler(game, EV_YOU_WIN, 0, 0);
+    }
+  }
+}
+
+static bool click(struct game_st *game, game_handler_f handler) {
+  bool result = true;
+  u32 k = game->selx + game->sely * BOARD_W;
+  if (game->difficulty & D_ONLYMINES) {
+    if (GET_STATUS(game->board[k]) != S_PRESSED) {
+      if (GET_STATUS(game->board[k]) == S_HIDDEN && game->notes[k] == -2) {
+        // can't click on flagged mines
+        return false;
+      } else {
+        check_onlymines(game, handler);
+      }
+    }
+  } else {
+    if (GET_STATUS(game->board[k]) == S_PRESSED) {
+      if (IS_EMPTY(game->board[k])) {
+        return false;
+      }
+      result = tile_collect(game, handler, game->board[k]) == 0;
+    } else {
+      if (GET_STATUS(game->board[k]) == S_HIDDEN && game->notes[k] == -2) {
+        // can't click on flagged mines
+        return false;
+      }
+      if (game->board[k] == T_LV11) {
+        // clicking a hidden mimic, so just make it visible, like a chest
+        set_status(game, game->selx, game->sely, S_VISIBLE);
+      } else {
+        if (game->board[k] == T_EMPTY) {
+          handler(game, EV_SFX, SFX_DIRT, 0);
+          handler(game, EV_PRESS_EMPTY, game->selx, game->sely);
+        }
+        set_status(game, game->selx, game->sely, S_PRESSED);
+        result = tile_attack(game, handler, game->board[k]) == 0;
+      }
+    }
+    for (i32 dy = -2; dy <= 2; dy++) {
+      for (i32 dx = -2; dx <= 2; dx++) {
+        tile_changed(game, handler, dx + game->selx, dy + game->sely);
+      }
+    }
+  }
+  return result;
+}
+
+bool game_click(struct game_st *game, game_handler_f handler) {
+  journal_begin(game);
+  bool result = click(game, handler);
+  journal_end(game);
+  return result;
+}
+
+bool game_levelup(struct game_st *game, game_handler_f handler) {
+  if (!(game->difficulty & D_ONLYMINES) && game->exp >= max_exp(game)) {
+    // level up!
+    journal_begin(game);
+    set_exp(game, game->exp - max_exp(game));
+    set_level(game, game->level + 1);
+    set_hp(game, max_hp(game));
+    journal_end(game);
+    handler(game, EV_HP_UPDATE, game->hp, max_hp(game));
+    handler(game, EV_EXP_UPDATE, game->exp, max_exp(game));
+    return true;
+  }
+  return false;
+}
+
+static void tile_changed(struct game_st *game, game_handler_f handler, i32 x, i32 y) {
+  if (!game->batch) {
+    handler(game, EV_TILE_UPDATE, x, y);
+  } else if (x >= 0 && x < BOARD_W && y >= 0 && y < BOARD_H) {
+    // duplicates collapse until the next flush
+    PLANE_SET(game->dirty, x, y);
+  }
+}
+
+void game_flush(struct game_st *game, game_handler_f handler) {
+  for (i32 y = 0; y < BOARD_H; y++) {
+    bitrow row = game->dirty[y];
+    game->dirty[y] = 0;
+    for (; row; row &= row - 1) {
+      handler(game, EV_TILE_UPDATE, row_ctz(row), y);
+    }
+  }
+}
+
+void game_note(struct game_st *game, game_handler_f handler, i8 note) {
+  journal_begin(game);
+  set_note(game, game->selx, game->sely, note);
+  journal_end(game);
+  tile_changed(game, handler, game->selx, game->sely);
+}
+
+void game_journal(struct game_st *game, struct journal_st *journal) {
+  game->journal = journal;
+  if (journal) {
+    journal->head = 0;
+    journal->used = 0;
+    journal->actions = 0;
+    journal->depth = 0;
+    journal->lost = 0;
+  }
+}
+
+bool game_undo(struct game_st *game, game_handler_f handler) {
+  struct journal_st *j = game->journal;
+  if (!j || j->depth || !j->actions) return false;
+  u8 hp = game->hp;
+  u8 exp = game->exp;
+  u8 level = game->level;
+  u8 *bytes = (u8 *)game;
+  for (;;) {
+    j->head = (j->head - 1) & (JOURNAL_SIZE - 1);
+    j->used--;
+    u32 entry = j->entries[j->head];
+    if (entry == JOURNAL_MARK) break;
+    size_t offset = entry >> 8;
+    u8 old = entry & 0xff;
+    if (offset >= offsetof(struct game_st, board)) {
+      i32 k = offset - offsetof(struct game_st, board);
+      set_tile(game, k % BOARD_W, k / BOARD_W, old);
+      tile_changed(game, handler, k % BOARD_W, k / BOARD_W);
+    } else if (offset >= offsetof(struct game_st, notes)) {
+      i32 k = offset - offsetof(struct game_st, notes);
+      set_note(game, k % BOARD_W, k / BOARD_W, (i8)old);
+      tile_changed(game, handler, k % BOARD_W, k / BOARD_W);
+    } else {
+      bytes[offset] = old;
+    }
+  }
+  j->actions--;
+  // the fields before the notes were written directly, so catch the hash up
+  game->hash ^=
+    zkey(Z_HP, hp) ^ zkey(Z_HP, game->hp) ^
+    zkey(Z_EXP, exp) ^ zkey(Z_EXP, game->exp) ^
+    zkey(Z_LEVEL, level) ^ zkey(Z_LEVEL, game->level);
+  if (game->hp != hp || game->level != level) {
+    handler(game, EV_HP_UPDATE, game->hp, max_hp(game));
+  }
+  if (game->exp != exp || game->level != level) {
+    handler(game, EV_EXP_UPDATE, game->exp, max_exp(game));
+  }
+  return true;
+}
+
+i32 game_tileicon(u32 type) {
+  return game_tiles[GET_TYPE(type)].icon;
+}
+
+i32 max_hp(struct game_st *game) {
+  static const i32 table[] = {5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12};
+  if (game->level < 16) {
+    return table[game->level];
+  }
+  return 13;
+}
+
+bool next_level_hp_increases(struct game_st *game) {
+  game->level++;
+  i32 m = max_hp(game);
+  game->level--;
+  return max_hp(game) + 1 == m;
+}
+
+i32 max_exp(struct game_st *game) {
+  static const i32 table[] = {4, 5, 7, 9, 9, 10, 12, 12, 12, 15, 18, 21, 21, 25};
+  if (game->level < 14) {
+    return table[game->level];
+  }
+  return 25;
+}
+
+static i32 threat_at(const u8 *board, i32 x, i32 y) {
+  if (x < 0 || x >= BOARD_W || y < 0 || y >= BOARD_H) return 0;
+  return game_tiles[GET_TYPE(board[x + y * BOARD_W])].threat;
+}
+
+i32 count_threat(const u8 *board, i32 x, i32 y) {
+  i32 result = 0;
+  for (i32 dy = -1; dy <= 1; dy++) {
+    i32 by = dy + y;
+    for (i32 dx = -1; dx <= 1; dx++) {
+      if (dy == 0 && dx == 0) continue;
+      i32 bx = dx + x;
+      result += threat_at(board, bx, by);
+    }
+  }
+
+  // check if we're in range of a lv5c
+  bool hidden = false;
+  i32 w = 0;
+  for (i32 dy = -2; dy <= 2 && !hidden; dy++) {
+    i32 by = dy + y;
+    if (by < 0 || by >= BOARD_H) goto next_dy;
+    for (i32 dx = -w; dx <= w && !hidden; dx++) {
+      i32 bx = dx + x;
+      if (bx < 0 || bx >= BOARD_W) continue;
+      if (GET_TYPEXY(board, bx, by) == T_LV5C) {
+        hidden = true;
+      }
+    }
+next_dy:
+    if (dy < 0) w++;
+    else w--;
+  }
+  if (hidden) {
+    // mask threat
+    result |= 0xff;
+  }
+
+  return result;
+}
+
+// same as count_threat, but from the cache
+i32 game_count_threat(struct game_st *game, i32 x, i32 y) {
+  i32 result = game->threat[x + y * BOARD_W];
+  if (PLANE_GET(game->witched, x, y)) {
+    // in range of a lv5c, so mask threat
+    result |= 0xff;
+  }
+  return result;
+}
+
+static i32 you_died(struct game_st *game, game_handler_f handler) {
+  set_status(game, game->selx, game->sely, S_KILLED);
+  tile_changed(game, handler, game->selx, game->sely);
+  game->win = 1;
+  if (!(game->difficulty & D_ONLYMINES)) {
+    // remove "level up" animation if it's there
+    handler(game, EV_EXP_UPDATE, game->exp, max_exp(game));
+  }
+  handler(game, EV_YOU_LOSE, game->selx, game->sely);
+  for (i32 y = 0, k = 0; y < BOARD_H; y++) {
+    for (i32 x = 0; x < BOARD_W; x++, k++) {
+      if (GET_STATUS(game->board[k]) == S_HIDDEN) {
+        set_status(game, x, y, S_VISIBLE);
+      }
+      tile_changed(game, handler, x, y);
+    }
+    handler(game, EV_WAIT, 2, 0);
+  }
+  return 0;
+}
+
+static void award_exp(struct game_st *game, game_handler_f handler, i32 amt) {
+  game->totalexp += amt;
+  set_exp(game, game->exp + amt);
+  handler(game, EV_SFX, amt < 9 ? SFX_EXP1 : SFX_EXP2, 0);
+  handler(game, EV_EXP_UPDATE, game->exp, max_exp(game));
+}
+
+static i32 replace_type(struct game_st *game, game_handler_f handler, u32 t) {
+  set_type(game, game->selx, game->sely, t);
+  return 0;
+}
+
+static i32 collect_monster_item(struct game_st *game, game_handler_f handler, i32 new_item) {
+  u32 k = game->selx + game->sely * BOARD_W;
+  i32 exp = game_tiles[GET_TYPE(game->board[k])].threat;
+  award_exp(game, handler, exp);
+  return replace_type(game, handler, new_item);
+}
+
+static i32 attack_monster(struct game_st *game, game_handler_f handler) {
+  u32 k = game->selx + game->sely * BOARD_W;
+  i32 exp = game_tiles[GET_TYPE(game->board[k])].threat;
+  if (exp > game->hp) {
+    set_hp(game, 0);
+    handler(game, EV_HP_UPDATE, game->hp, max_hp(game));
+    return you_died(game, handler);
+  }
+  set_hp(game, game->hp - exp);
+  handler(game, EV_SFX, game_tiles[GET_TYPE(game->board[k])].grunt, 0);
+  handler(game, EV_HP_UPDATE, game->hp, max_hp(game));
+  return 0;
+}
+
+static i32 attack_monster_group(struct game_st *game, game_handler_f handler, i32 it0, i32 it1) {
+  u32 k = game->selx + game->sely * BOARD_W;
+  i32 exp = game_tiles[GET_TYPE(game->board[k])].threat;
+  if (exp > game->hp) {
+    set_hp(game, 0);
+    handler(game, EV_HP_UPDATE, game->hp, max_hp(game));
+    return you_died(game, handler);
+  }
+  set_hp(game, game->hp - exp);
+  handler(game, EV_SFX, game_tiles[GET_TYPE(game->board[k])].grunt, 0);
+  handler(game, EV_HP_UPDATE, game->hp, max_hp(game));
+  i32 type = GET_TYPE(game->board[k]);
+  set_type(game, game->selx, game->sely, T_EMPTY);
+  // is this the last one?
+  bool last = true;
+  for (i32 i = 0; i < BOARD_SIZE && last; i++) {
+    last = GET_TYPE(game->board[i]) != type;
+  }
+  set_type(game, game->selx, game->sely, last ? it1 : it0);
+  return 0;
+}
+
+static void reveal(struct game_st *game, game_handler_f handler, i32 x, i32 y) {
+  if (x < 0 || x >= BOARD_W || y < 0 || y >= BOARD_H) return;
+  i32 k = x + y * BOARD_W;
+  if (GET_STATUS(game->board[k]) == S_HIDDEN) {
+    if (
+      IS_EMPTY(game->board[k]) ||
+      GET_TYPE(game->board[k]) == T_WALL ||
+      IS_ITEM(game->board[k]) ||
+      IS_CHEST(game->board[k])
+    ) {
+      if (game->board[k] == T_EMPTY) {
+        handler(game, EV_PRESS_EMPTY, x, y);
+      }
+      set_status(game, x, y, S_PRESSED);
+    } else {
+      set_status(game, x, y, S_VISIBLE);
+    }
+    tile_changed(game, handler, x, y);
+  }
+}
+
+static i32 tile_collect(struct game_st *game, game_handler_f handler, u32 type) {
+  const struct game_tile_st *tile = &game_tiles[GET_TYPE(type)];
+  switch (tile->action) {
+    case TA_NONE:
+      return 0;
+    case TA_MONSTER:
+    case TA_GROUP:
+      return collect_monster_item(game, handler, tile->reward);
+    case TA_MINE:
+      handler(game, EV_SFX, SFX_MINE, 0);
+      return you_died(game, handler);
+    case TA_WALL: {
+      if (game->hp <= 0) {
+        handler(game, EV_SFX, SFX_BUMP, 0);
+        return -1;
+      }
+      // spend extra health for exp
+      handler(game, EV_SFX, SFX_WALL, 0);
+      i32 item = T_EMPTY;
+      if (game->hp >= 6) {
+        set_hp(game, game->hp - 6);
+        item = T_ITEM_EXP5;
+      } else if (game->hp >= 4) {
+        set_hp(game, game->hp - 4);
+        item = T_ITEM_EXP3;
+      } else if (game->hp >= 2) {
+        set_hp(game, game->hp - 2);
+        item = T_ITEM_EXP1;
+      } else {
+        set_hp(game, 0);
+      }
+      handler(game, EV_HP_UPDATE, game->hp, max_hp(game));
+      return replace_type(game, handler, item);
+    }
+    case TA_CHEST:
+      handler(game, EV_SFX, SFX_CHEST, 0);
+      return replace_type(game, handler, tile->reward);
+    case TA_HEAL:
+      set_hp(game, max_hp(game));
+      handler(game, EV_SFX, SFX_HEART, 0);
+      handler(game, EV_HP_UPDATE, game->hp, max_hp(game));
+      return replace_type(game, handler, tile->reward);
+    case TA_EYE:
+      handler(game, EV_SFX, SFX_EYE, 0);
+      for (i32 dy = -2; dy <= 2; dy++) {
+        i32 w = dy == 0 ? 2 : dy == 1 || dy == -1 ? 1 : 0;
+        for (i32 dx = -w; dx <= w; dx++) {
+          reveal(game, handler, dx + game->selx, dy + game->sely);
+        }
+      }
+      return replace_type(game, handler, tile->reward);
+    case TA_EYE2: {
+      handler(game, EV_SFX, SFX_EYE, 0);
+      // we want to find the best spot to reveal, so we will score each location
+      i32 best_score = 0;
+      i32 best_x = 0;
+      i32 best_y = 0;
+      i32 same_score = 0;
+      for (i32 y = 0; y < BOARD_H - 2; y++) {
+        for (i32 x = 0; x < BOARD_W - 2; x++) {
+          // calculate score of revealing this location
+          i32 score = 0;
+          i32 minecount = 0;
+          i32 wallcount = 0;
+          for (i32 dy = 0; dy < 3; dy++) {
+            for (i32 dx = 0; dx < 3; dx++) {
+              i32 k = (x + dx) + (y + dy) * BOARD_W;
+              u8 t = game->board[k];
+              if (GET_STATUS(t) == S_HIDDEN) {
+                if (threat_at(game->board, x + dx, y + dy) < 8) {
+                  score++;
+                }
+                score += 3;
+                if (GET_TYPE(t) == T_LV8) {
+                  score -= 10;
+                } else if (GET_TYPE(t) == T_MINE) {
+                  minecount++;
+                } else if (GET_TYPE(t) == T_WALL) {
+                  wallcount++;
+                }
+              }
+            }
+          }
+          if (minecount == 1) score += 12;
+          if (wallcount == 1) score += 9;
+          else if (wallcount > 1) score -= 9;
+          if (x == 0 && y == 0) {
+            best_score = score;
+          } else {
+            if (score > best_score) {
+              best_score = score;
+              best_x = x;
+              best_y = y;
+              same_score = 0;
+            } else if (score == best_score) {
+              same_score++;
+              if (rnd_pick(&game->rnd, same_score)) {
+                best_x = x;
+                best_y = y;
+              }
+            }
+          }
+        }
+      }
+      // reveal at best_x/y
+      for (i32 dy = 0; dy < 3; dy++) {
+        for (i32 dx = 0; dx < 3; dx++) {
+          reveal(game, handler, best_x + dx, best_y + dy);
+        }
+      }
+      return replace_type(game, handler, tile->reward);
+    }
+    case TA_SHOW1:
+      handler(game, EV_SFX, SFX_EYE, 0);
+      for (i32 y = 0, k = 0; y < BOARD_H; y++) {
+        for (i32 x = 0; x < BOARD_W; x++, k++) {
+          if (GET_TYPE(game->board[k]) == T_LV1A) {
+            reveal(game, handler, x, y);
+          }
+        }
+      }
+      return replace_type(game, handler, tile->reward);
+    case TA_SHOW5:
+      handler(game, EV_SFX, SFX_EYE, 0);
+      for (i32 y = 0, k = 0; y < BOARD_H; y++) {
+        for (i32 x = 0; x < BOARD_W; x++, k++) {
+          i32 t = GET_TYPE(game->board[k]);
+          if (t == T_LV5A || t == T_LV8) {
+            reveal(game, handler, x, y);
+          }
+        }
+      }
+      return replace_type(game, handler, tile->reward);
+    case TA_EXP:
+      award_exp(game, handler, tile->value);
+      return replace_type(game, handler, tile->reward);
+    case TA_REJECT:
+      handler(game, EV_SFX, SFX_REJECT, 0);
+      return replace_type(game, handler, tile->reward);
+    case TA_LAVA:
+      handler(game, EV_SHOW_LAVA, 0, 0);
+      for (i32 y = 0; y < BOARD_H; y++) {
+        for (bitrow mines = game->planes[P_MINE][y]; mines; mines &= mines - 1) {
+          i32 x = row_ctz(mines);
+          set_tile(game, x, y, T_LAVA | (S_PRESSED << 6));
+          for (i32 dy = -1; dy <= 1; dy++) {
+            for (i32 dx = -1; dx <= 1; dx++) {
+              tile_changed(game, handler, x + dx, y + dy);
+            }
+          }
+        }
+      }
+      return replace_type(game, handler, tile->reward);
+    case TA_EXIT:
+      game->win = 2;
+      handler(game, EV_SFX, SFX_EXIT, 0);
+      handler(game, EV_YOU_WIN, 0, 0);
+      return 0;
+  }
+  return -1;
+}
+
+static i32 tile_attack(struct game_st *game, game_handler_f handler, u32 type) {
+  const struct game_tile_st *tile = &game_tiles[GET_TYPE(type)];
+  switch (tile->action) {
+    case TA_MONSTER:
+      return attack_monster(game, handler);
+    case TA_GROUP:
+      return attack_monster_group(game, handler, tile->group[0], tile->group[1]);
+    case TA_MINE:
+      handler(game, EV_SFX, SFX_MINE, 0);
+      return you_died(game, handler);
+  }
+  return 0;
+}
+
+static i32 known_threat_at(struct game_st *game, i32 x, i32 y) {
+  i32 k = x + y * BOARD_W;
+  i32 s = GET_STATUS(game->board[k]);
+  if (s == S_HIDDEN) {
+    if (game->notes[k] == -2) { // noted mine
+      return 0x100;
+    } else if (game->notes[k] > 0) { // noted threat
+      return game->notes[k];
+    }
+    return -1; // unknown
+  }
+  // visible or pressed, so query type directly
+  return threat_at(game->board, x, y);
+}
+
+static i32 remaining_count_threat(struct game_st *game, i32 x, i32 y) {
+  i32 ct = game_count_threat(game, x, y);
+  for (i32 dy = -1; dy <= 1; dy++) {
+    i32 by = y + dy;
+    if (by < 0 || by >= BOARD_H) continue;
+    for (i32 dx = -1; dx <= 1; dx++) {
+      if (dy == 0 && dx == 0) continue;
+      i32 bx = x + dx;
+      if (bx < 0 || bx >= BOARD_W) continue;
+      i32 kt = known_threat_at(game, bx, by);
+      if (kt >= 0x100) {
+        ct -= 0x100;
+      } else if (kt > 0 && kt < 0xff) {
+        if ((ct & 0xff) != 0xff) {
+          ct -= kt;
+        }
+      }
+    }
+  }
+  return ct;
+}
+
+static inline void refresh_remain(struct game_st *game, i32 x, i32 y) {
+  i32 k = x + y * BOARD_W;
+  i32 ct = remaining_count_threat(game, x, y);
+  if (ct != game->solver.remain[k]) {
+    game->solver.remain[k] = ct;
+    plane_box(game->solver.stale_could, x, y);
+  }
+}
+
+static inline void refresh_could(struct game_st *game, i32 x, i32 y) {
+  // hypothesis: the tile has threat t, which is disproven if t exceeds any adjacent remain
+  i32 lowest = 0x7fff;
+  for (i32 by = y - 1; by <= y + 1; by++) {
+    if (by < 0 || by >= BOARD_H) continue;
+    bitrow open = game->planes[P_PRESSED][by] & game->planes[P_EMPTY][by];
+    for (u32 n = row_window(open, x, 1) & (by == y ? 5 : 7); n; n &= n - 1) {
+      i32 ct = game->solver.remain[x - 1 + bit_ctz(n) + by * BOARD_W];
+      if (ct < lowest) lowest = ct;
+    }
+  }
+  u32 could = 0;
+  if (lowest >= 0x100) could |= 1 << 12;
+  if (lowest >= 1) could |= (2 << (lowest < 11 ? lowest : 11)) - 2;
+  game->solver.could[x + y * BOARD_W] = could;
+}
+
+// bring solver.remain and solver.could up to date with the board
+static void solver_refresh(struct game_st *game) {
+  for (i32 y = 0; y < BOARD_H; y++) {
+    bitrow row = game->solver.stale[y] & game->planes[P_PRESSED][y] & game->planes[P_EMPTY][y];
+    game->solver.stale[y] = 0;
+    for (; row; row &= row - 1) {
+      refresh_remain(game, row_ctz(row), y);
+    }
+  }
+  for (i32 y = 0; y < BOARD_H; y++) {
+    bitrow row = game->solver.stale_could[y];
+    game->solver.stale_could[y] = 0;
+    for (; row; row &= row - 1) {
+      refresh_could(game, row_ctz(row), y);
+    }
+  }
+}
+
+// solver_refresh a cell at a time, stopping when budget runs out; returns true once it's done
+static bool solver_step(struct game_st *game, i32 *budget) {
+  for (i32 y = 0; y < BOARD_H; y++) {
+    bitrow row = game->solver.stale[y] & game->planes[P_PRESSED][y] & game->planes[P_EMPTY][y];
+    for (; row; row &= row - 1, (*budget)--) {
+      if (*budget <= 0) {
+        game->solver.stale[y] = row;
+        return false;
+      }
+      refresh_remain(game, row_ctz(row), y);
+    }
+    game->solver.stale[y] = 0;
+  }
+  for (i32 y = 0; y < BOARD_H; y++) {
+    for (bitrow row = game->solver.stale_could[y]; row; row &= row - 1, (*budget)--) {
+      if (*budget <= 0) {
+        game->solver.stale_could[y] = row;
+        return false;
+      }
+      refresh_could(game, row_ctz(row), y);
+    }
+    game->solver.stale_could[y] = 0;
+  }
+  return true;
+}
+
+static i32 witch_evidence(struct game_st *game, i32 x, i32 y) { // -1 = impossible
+  i32 evidence = 0;
+  i32 w = 0;
+  for (i32 dy = -2; dy <= 2; dy++) {
+    i32 by = dy + y;
+    if (by < 0 || by >= BOARD_H) goto next_dy;
+    for (i32 dx = -w; dx <= w; dx++) {
+      i32 bx = dx + x;
+      if (bx < 0 || bx >= BOARD_W) continue;
+      i32 k = bx + by * BOARD_W;
+      if (dx == 0 && dy == 0) {
+        switch (GET_STATUS(game->board[k])) {
+          case S_HIDDEN:
+            if (game->notes[k] == 5) {
+              evidence++;
+            } else if (game->notes[k] != -3) {
+              return -1;
+            }
+            break;
+          case S_VISIBLE:
+          case S_PRESSED:
+            return GET_TYPE(game->board[k]) == T_LV5C ? 999 : -1;
+        }
+      } else if (
+        GET_STATUS(game->board[k]) != S_HIDDEN &&
+        IS_EMPTY(game->board[k])
+      ) {
+        i32 th = game_count_threat(game, bx, by);
+        if ((th & 0xff) == 0xff) {
+          evidence++;
+        } else {
+          return -1;
+        }
+      }
+    }
+next_dy:
+    if (dy < 0) w++;
+    else w--;
+  }
+  return evidence;
+}
+
+static i32 mummy_evidence(struct game_st *game, i32 x, i32 y, bool phase1) { // -1 = impossible
+  i32 evidence = 0;
+  for (i32 dy = -2; dy <= 2; dy++) {
+    i32 by = dy + y;
+    if (by < 0 || by >= BOARD_H) continue;
+    for (i32 dx = -2; dx <= 2; dx++) {
+      i32 bx = dx + x;
+      if (bx < 0 || bx >= BOARD_W) continue;
+      i32 k = bx + by * BOARD_W;
+      if (dx == 0 && dy == 0) {
+        switch (GET_STATUS(game->board[k])) {
+          case S_HIDDEN:
+            if (game->notes[k] != 1 && game->notes[k] != -3) {
+              return -1;
+            }
+            break;
+          case S_VISIBLE:
+          case S_PRESSED:
+            return GET_TYPE(game->board[k]) == T_LV1B ? 10 : -1;
+        }
+      } else if (dx >= -1 && dx <= 1 && dy >= -1 && dy <= 1) {
+        // needs to be an 8
+        i32 th = known_threat_at(game, bx, by);
+        if (th == 8) {
+          evidence++;
+        } else if ((phase1 && th == 0) || th > 0) {
+          return -1;
+        }
+      } else {
+        // needs to *not* be an 8
+        i32 th = known_threat_at(game, bx, by);
+        if (th == 8) {
+          return -1;
+        }
+      }
+    }
+  }
+  return evidence;
+}
+
+static i32 count_hidden(struct game_st *game, i32 x, i32 y) {
+  // hidden tiles without notes
+  i32 hidden = 0;
+  for (i32 by = y - 1; by <= y + 1; by++) {
+    if (by < 0 || by >= BOARD_H) continue;
+    bitrow row = game->planes[P_HIDDEN][by] & ~game->planes[P_NOTED][by];
+    hidden += popcount(row_window(row, x, 1));
+  }
+  return hidden;
+}
+
+i32 game_forced(struct game_st *game, u32 *queue, i32 size) {
+  // same deductions as the start of game_hint, but collects all of them instead of the first
+  solver_refresh(game);
+  bitplane queued;
+  for (i32 y = 0; y < BOARD_H; y++) {
+    queued[y] = 0;
+  }
+  i32 count = 0;
+  for (i32 y = 0; y < BOARD_H; y++) {
+    bitrow open = game->planes[P_PRESSED][y] & game->planes[P_EMPTY][y];
+    for (; open; open &= open - 1) {
+      i32 x = row_ctz(open);
+      i32 threat = game->solver.remain[x + y * BOARD_W];
+      i32 ux = -1, uy = -1, uc = 0;
+      for (i32 dy = -1; dy <= 1; dy++) {
+        i32 by = y + dy;
+        if (by < 0 || by >= BOARD_H) continue;
+        for (i32 dx = -1; dx <= 1; dx++) {
+          if (dy == 0 && dx == 0) continue;
+          i32 bx = x + dx;
+          if (bx < 0 || bx >= BOARD_W) continue;
+          if (known_threat_at(game, bx, by) < 0) {
+            uc++;
+            ux = bx;
+            uy = by;
+            if (threat == 0 && !PLANE_GET(queued, bx, by)) {
+              // no threat here, so click all cells around it
+              PLANE_SET(queued, bx, by);
+              queue[count++] = H_CLICK(bx, by);
+              if (count >= size) return count;
+            }
+          }
+        }
+      }
+      if (uc == 1 && !PLANE_GET(queued, ux, uy)) {
+        // a single unknown, and we know the threat, so note it
+        if (threat > 0 && threat < 0xff) {
+          PLANE_SET(queued, ux, uy);
+          queue[count++] = H_NOTE(ux, uy, threat);
+        } else if (threat == 0x100 || threat == 0x1ff) {
+          PLANE_SET(queued, ux, uy);
+          queue[count++] = H_NOTE(ux, uy, -2); // mine
+        }
+        if (count >= size) return count;
+      }
+    }
+  }
+  return count;
+}
+
+bool game_forced_valid(struct game_st *game, u32 hint) {
+  // only clicks and notes are queued, and their target must still be unknown
+  i32 x = hint & 0xff;
+  i32 y = (hint >> 8) & 0xff;
+  return !game->win && ((hint >> 16) & 0xff) <= 1 && known_threat_at(game, x, y) < 0;
+}
+
+// tuned via testing *shrug*
+const struct hint_weights_st hint_weights_default = {
+  .unknown = 100,
+  .threat = 6,
+  .bias = 2,
+  .lv3 = 7,
+  .lv10 = 14,
+  .witch = 3,
+  .hidden = 2
+};
+
+// game_hint's body, inlined into a copy per knowledge mask below so the unused branches fold away
+static inline __attribute__((always_inline)) i32 hint_impl(
+  struct game_st *game,
+  game_handler_f handler,
+  i32 knowledge,
+  const struct hint_weights_st *w,
+  const i16 *witches // witch_evidence of every cell worked out ahead of time, or NULL
+) {
+  #define K_SAVELV1LV2()   (knowledge &   1)
+  #define K_ATTAKCLV3()    (knowledge &   2)
+  #define K_WALL()         (knowledge &   4)
+  #define K_ATTACKLV10()   (knowledge &   8)
+  #define K_LV9HEAL()      (knowledge &  16)
+  #define K_LV9MIRROR()    (knowledge &  32)
+  #define K_MUMMY()        (knowledge &  64)
+  #define K_WITCH()        (knowledge & 128)
+
+  if (game->hp == 0 && game->exp >= max_exp(game)) {
+    // level up aggressively to restore health asap
+    return H_LEVELUP();
+  }
+  solver_refresh(game);
+  i32 heal_score = 0, heal_x = -1, heal_y = -1;
+  for (i32 y = 0, k = 0; y < BOARD_H; y++) {
+    for (i32 x = 0; x < BOARD_W; x++, k++) {
+      i32 s = GET_STATUS(game->board[k]);
+      i32 t = GET_TYPE(game->board[k]);
+      if ((s == S_VISIBLE || s == S_PRESSED) && t == T_ITEM_HEAL) {
+        i32 score = count_hidden(game, x, y);
+        if (heal_x < 0 || score > heal_score) {
+          heal_score = score;
+          heal_x = x;
+          heal_y = y;
+        }
+      }
+      if (
+        // always collect items (except healing), exp, and chests ASAP
+        (s == S_VISIBLE || s == S_PRESSED) && (
+          t == T_ITEM_EYE ||
+          t == T_ITEM_EYE2 ||
+          t == T_ITEM_SHOW1 ||
+          t == T_ITEM_SHOW5 ||
+          t == T_ITEM_EXP1 ||
+          t == T_ITEM_EXP3 ||
+          t == T_ITEM_EXP5 ||
+          t == T_ITEM_EXP6 ||
+          t == T_ITEM_EXP9 ||
+          t == T_ITEM_LV3B0 ||
+          t == T_ITEM_LV3C0 ||
+          t == T_ITEM_LAVA ||
+          t == T_ITEM_EXIT ||
+          IS_CHEST(t) ||
+          (game->hp >= 13 && t == T_LV13) // finish the game ASAP!
+        )
+      ) {
+        if (t == T_ITEM_EXIT) {
+          // about to win, print stats
+          handler(game, EV_DEBUGLOG, 0, game->losthp);
+        }
+        return H_CLICK(x, y);
+      } else if (s == S_PRESSED && IS_EMPTY(t)) {
+        // attempt to note adjacent cells based on this threat
+        i32 threat = game->solver.remain[k];
+        i32 ux = -1, uy = -1, uc = 0;
+        for (i32 dy = -1; dy <= 1; dy++) {
+          i32 by = y + dy;
+          if (by < 0 || by >= BOARD_H) continue;
+          for (i32 dx = -1; dx <= 1; dx++) {
+            if (dy == 0 && dx == 0) continue;
+            i32 bx = x + dx;
+            if (bx < 0 || bx >= BOARD_W) continue;
+            if (known_threat_at(game, bx, by) < 0) {
+              // unknown
+              uc++;
+              ux = bx;
+              uy = by;
+            }
+          }
+        }
+        if (uc > 0) {
+          if (threat == 0) {
+            // no threat here, so click all cells around it
+            return H_CLICK(ux, uy);
+          }
+          if (uc == 1) {
+            // a single unknown, and we know the threat, so note it
+            if (threat > 0 && threat < 0xff) {
+              return H_NOTE(ux, uy, threat);
+            } else if (threat == 0x100 || threat == 0x1ff) {
+              return H_NOTE(ux, uy, -2); // mine
+            }
+          }
+        }
+      }
+    }
+  }
+
+  if (K_MUMMY()) { // find and kill the mummy
+    if (game->mummy.size == 0) {
+      // phase 1 - find potential locations
+      #define CHECK(sx, sy)  do {                        \
+          if (mummy_evidence(game, sx, sy, true) > 0) {  \
+            game->mummy.x[game->mummy.size] = sx;        \
+            game->mummy.y[game->mummy.size] = sy;        \
+            game->mummy.size++;                          \
+            handler(game, EV_DEBUGLOG, 0x20, sx);        \
+            handler(game, EV_DEBUGLOG, 0x21, sy);        \
+          }                                              \
+        } while (0)
+      for (i32 y = 1; y < BOARD_H - 1; y++) {
+        CHECK(0, y);
+        CHECK(BOARD_W - 1, y);
+      }
+      for (i32 x = 1; x < BOARD_W - 1; x++) {
+        CHECK(x, 0);
+        CHECK(x, BOARD_H - 1);
+      }
+      #undef CHECK
+    }
+    if (game->mummy.size > 1) {
+      // phase 2 - eliminate until only one left
+      for (i32 i = 0; i < game->mummy.size; i++) {
+        if (mummy_evidence(game, game->mummy.x[i], game->mummy.y[i], false) < 0) {
+          // this one is eliminated
+          handler(game, EV_DEBUGLOG, 0x22, game->mummy.x[i]);
+          handler(game, EV_DEBUGLOG, 0x23, game->mummy.y[i]);
+          game->mummy.size--;
+          for (i32 j = i; j < game->mummy.size; j++) {
+            game->mummy.x[j] = game->mummy.x[j + 1];
+            game->mummy.y[j] = game->mummy.y[j + 1];
+          }
+          i--;
+        }
+      }
+    }
+    if (game->mummy.size == 1) {
+      // phase 3 - kill it! or note it if no HP
+      i32 x = game->mummy.x[0];
+      i32 y = game->mummy.y[0];
+      if (game->hp >= 1) {
+        game->mummy.size = -1; // all done!
+        return H_CLICK(x, y);
+      } else if (game->notes[x + y * BOARD_W] == -3) {
+        return H_NOTE(x, y, 1);
+      }
+    }
+  }
+
+  if (K_LV9HEAL() || K_LV9MIRROR()) { // mirror lv9's and kill them if we can
+    for (i32 y = 0, k = 0; y < BOARD_H; y++) {
+      for (i32 x = 0; x < BOARD_W; x++, k++) {
+        if (known_threat_at(game, x, y) == 9) {
+          // find mirror
+          i32 mx = BOARD_W - x - 1;
+          if (K_LV9MIRROR() && known_threat_at(game, mx, y) < 0) {
+            return H_NOTE(mx, y, 9);
+          } else if (K_LV9HEAL()) {
+            // we know about both lv9's, so see if we can kill one
+            if (game->hp >= 9) {
+              bool s1 = GET_STATUSXY(game->board, x, y) == S_HIDDEN;
+              bool s2 = GET_STATUSXY(game->board, mx, y) == S_HIDDEN && K_LV9MIRROR();
+              if (s1 && s2) {
+                // could kill either, favor the one with most hidden's
+                if (count_hidden(game, x, y) > count_hidden(game, mx, y)) {
+                  return H_CLICK(x, y);
+                } else {
+                  return H_CLICK(mx, y);
+                }
+              } else if (s1) {
+                return H_CLICK(x, y);
+              } else if (s2) {
+                return H_CLICK(mx, y);
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+
+  // collect free exp (after learning from it, above)
+  for (i32 y = 0; y < BOARD_H; y++) {
+    bitrow row = game->planes[P_PRESSED][y] & game->planes[P_MONSTER][y];
+    if (row) {
+      return H_CLICK(row_ctz(row), y);
+    }
+  }
+
+  { // find a useful cell to challenge
+    i32 best_score = 0;
+    i32 same_score = 0;
+    i32 best_x = -1;
+    i32 best_y = -1;
+    for (i32 y = 0, k = 0; y < BOARD_H; y++) {
+      for (i32 x = 0; x < BOARD_W; x++, k++) {
+        i32 score = 0;
+
+        // get the threat (or worst case scenario)
+        i32 threat = known_threat_at(game, x, y);
+        if (threat < 0) { // unknown threat, calculate worst case
+          score += w->unknown; // favor cells that have unknown threats
+          u32 could = game->solver.could[k];
+          threat = (could & (1 << 12)) || !could ? 0x100 : bit_top(could);
+        }
+        i32 witch = -1;
+        if (K_WITCH() && threat >= 5) {
+          witch = witches ? witches[k] : witch_evidence(game, x, y);
+        }
+        i32 hidden = 0;
+
+        if (threat == 0) {
+          if (GET_STATUS(game->board[k]) == S_HIDDEN) {
+            // click hidden non-threats immediately
+            return H_CLICK(x, y);
+          }
+        } else if (threat <= game->hp) {
+          // we *could* kill this monster... should we?
+          // see how many cells we would get information about
+          hidden = count_hidden(game, x, y);
+          score += witch > 0 ? witch * w->witch : 0;
+          if (K_SAVELV1LV2() && (threat == 1 || threat == 2)) {
+            score += threat * w->threat; // avoid killing 1-2's since they're most useful
+          } else if (K_ATTAKCLV3() && threat == 3) {
+            score += w->lv3 * w->threat; // favor killing 3's for delayed exp
+          } else if (K_ATTACKLV10() && threat == 10) {
+            score += w->lv10 * w->threat; // favor lv10 over lv11, because it exposes mines
+          } else {
+            score += (threat + w->bias) * w->threat; // favor higher level monsters
+          }
+          score += hidden * w->hidden; // favor cells next to unknowns
+        } else if (witch > 0) {
+          // there is a pretty good chance this cell is a witch -- this *could* kill us!
+          if (game->hp >= 5 && threat < 0x100 && witch >= 4) score += witch;
+          else continue;
+        } else {
+          // this cell would kill us!
+          continue;
+        }
+        if (score <= 0) continue;
+        if (score > best_score) {
+          best_score = score;
+          same_score = 0;
+          best_x = x;
+          best_y = y;
+        } else if (score == best_score) {
+          same_score++;
+          if (rnd_pick(&game->rnd, same_score)) {
+            best_x = x;
+            best_y = y;
+          }
+        }
+      }
+    }
+    if (best_x >= 0) {
+      return H_CLICK(best_x, best_y);
+    }
+  }
+
+  // not enough HP to make progress, so try and kill a wall
+  if (K_WALL() && game->hp > 0) {
+    for (i32 y = 0; y < BOARD_H; y++) {
+      bitrow row = game->planes[P_WALL][y] & ~game->planes[P_HIDDEN][y];
+      if (row) {
+        game->losthp++;
+        handler(game, EV_DEBUGLOG, 0x10, game->losthp);
+        return H_CLICK(row_ctz(row), y);
+      }
+    }
+  }
+
+  // no other action, so heal if possible
+  if (game->exp >= max_exp(game)) {
+    game->losthp += game->hp;
+    if (game->hp > 0) {
+      handler(game, EV_DEBUGLOG, 0x11, game->losthp);
+    }
+    return H_LEVELUP();
+  } else if (heal_x >= 0) {
+    game->losthp += game->hp;
+    if (game->hp > 0) {
+      handler(game, EV_DEBUGLOG, 0x12, game->losthp);
+    }
+    return H_CLICK(heal_x, heal_y);
+  }
+
+  // oh boy, I guess we're screwed
+
+  handler(game, EV_DEBUGLOG, 0xff, game->losthp);
+  return H_GIVEUP();
+  #undef K_SAVELV1LV2
+  #undef K_ATTAKCLV3
+  #undef K_WALL
+  #undef K_ATTACKLV10
+  #undef K_LV9HEAL
+  #undef K_LV9MIRROR
+  #undef K_MUMMY
+  #undef K_WITCH
+}
+
+#define HINT_VARIANT(name, k)                                          \
+  static i32 name(struct game_st *game, game_handler_f handler) {     \
+    return hint_impl(game, handler, k, &hint_weights_default, NULL);   \
+  }
+#ifndef SYS_GBA
+// the masks used by the generator
+HINT_VARIANT(hint_k0, 0)
+HINT_VARIANT(hint_k1, 1)
+HINT_VARIANT(hint_k7, 7)
+HINT_VARIANT(hint_k31, 31)
+HINT_VARIANT(hint_k63, 63)
+#endif
+#undef HINT_VARIANT
+
+// the game always hints with full knowledge, sometimes with the witches from a hint job
+static __attribute__((noinline)) i32 hint_full(
+  struct game_st *game,
+  game_handler_f handler,
+  const i16 *witches
+) {
+  return hint_impl(game, handler, -1, &hint_weights_default, witches);
+}
+
+static i32 hint_kall(struct game_st *game, game_handler_f handler) {
+  return hint_full(game, handler, NULL);
+}
+
+static const struct {
+  i32 knowledge;
+  i32 (*hint)(struct game_st *game, game_handler_f handler);
+} hint_variants[] = {
+#ifndef SYS_GBA
+  { 0, hint_k0 },
+  { 1, hint_k1 },
+  { 7, hint_k7 },
+  { 31, hint_k31 },
+  { 63, hint_k63 },
+#endif
+  { -1, hint_kall }
+};
+
+static __attribute__((noinline)) i32 hint_generic(
+  struct game_st *game,
+  game_handler_f handler,
+  i32 knowledge,
+  const struct hint_weights_st *weights
+) {
+  return hint_impl(game, handler, knowledge, weights, NULL);
+}
+
+i32 game_hint(struct game_st *game, game_handler_f handler, i32 knowledge) {
+  for (u32 i = 0; i < sizeof(hint_variants) / sizeof(hint_variants[0]); i++) {
+    if (hint_variants[i].knowledge == knowledge) {
+      return hint_variants[i].hint(game, handler);
+    }
+  }
+  return hint_generic(game, handler, knowledge, &hint_weights_default);
+}
+
+void game_hint_cancel(struct hint_job_st *job) {
+  job->stage = 0;
+}
+
+bool game_hint_step(
+  struct game_st *game,
+  game_handler_f handler,
+  struct hint_job_st *job,
+  i32 budget
+) {
+  if (job->stage && job->hash != game->hash) {
+    // the board moved on, so start over
+    job->stage = 0;
+  }
+  switch (job->stage) {
+    case 0:
+      job->hash = game->hash;
+      job->next = 0;
+      job->stage = 1;
+      // fall through
+    case 1:
+      if (!solver_step(game, &budget)) return false;
+      job->stage = 2;
+      // fall through
+    case 2:
+      // witch_evidence reads a 5x5 diamond, so it costs a few cells of budget each
+      for (; job->next < BOARD_SIZE; job->next++, budget -= 4) {
+        if (budget <= 0) return false;
+        job->witches[job->next] = witch_evidence(game, job->next % BOARD_W, job->next / BOARD_W);
+      }
+      job->result = hint_full(game, handler, job->witches);
+      job->stage = 3;
+      // fall through
+    case 3:
+      return true;
+  }
+  return false;
+}
+
+i32 game_hint_weighted(
+  struct game_st *game,
+  game_handler_f handler,
+  i32 knowledge,
+  const struct hint_weights_st *weights
+) {
+  if (weights == &hint_weights_default) {
+    return game_hint(game, handler, knowledge);
+  }
+  return hint_generic(game, handler, knowledge, weights);
+}
+
+void movelog_start(struct movelog_st *log, i32 difficulty, u32 seed) {
+  log->seed = seed;
+  log->frames = 0;
+  log->last = 0;
+  log->bits = 0;
+  log->difficulty = difficulty;
+  log->full = 0;
+}
+
+// bits per coordinate in a move log entry
+#define MOVELOG_XBITS  (BOARD_W <= 16 ? 4 : BOARD_W <= 32 ? 5 : 6)
+#define MOVELOG_YBITS  (BOARD_H <= 16 ? 4 : BOARD_H <= 32 ? 5 : 6)
+
+static void movelog_put(struct movelog_st *log, u32 value, i32 count) {
+  for (i32 i = 0; i < count; i++, log->bits++) {
+    u8 *d = &log->data[log->bits >> 3];
+    u8 m = 1 << (log->bits & 7);
+    *d = (value >> i) & 1 ? *d | m : *d & ~m;
+  }
+}
+
+static u32 movelog_get(const struct movelog_st *log, u32 *pos, i32 count) {
+  u32 value = 0;
+  for (i32 i = 0; i < count; i++, (*pos)++) {
+    value |= ((log->data[*pos >> 3] >> (*pos & 7)) & 1) << i;
+  }
+  return value;
+}
+
+void movelog_add(struct movelog_st *log, u32 move) {
+  if (log->full) return;
+  static const u8 kinds[] = {0, 1, 2, 0xff, 3}; // by hint action
+  u32 action = (move >> 16) & 0xff;
+  u32 kind = action < sizeof(kinds) ? kinds[action] : 0xff;
+  if (kind == 0xff) return;
+  u32 delta = log->frames - log->last;
+  i32 size = 2 + (kind == 2 ? 0 : MOVELOG_XBITS + MOVELOG_YBITS) + (kind == 1 ? 5 : 0);
+  for (u32 d = delta; ; d >>= 3) {
+    size += 4;
+    if (d < 8) break;
+  }
+  if (log->bits + size > MOVELOG_SIZE * 8) {
+    log->full = 1;
+    return;
+  }
+  movelog_put(log, kind, 2);
+  if (kind != 2) {
+    movelog_put(log, move & 0xff, MOVELOG_XBITS);
+    movelog_put(log, (move >> 8) & 0xff, MOVELOG_YBITS);
+  }
+  if (kind == 1) {
+    movelog_put(log, (i8)(move >> 24) + 3, 5);
+  }
+  for (;;) {
+    movelog_put(log, delta & 7, 3);
+    delta >>= 3;
+    movelog_put(log, delta ? 1 : 0, 1);
+    if (!delta) break;
+  }
+  log->last = log->frames;
+}
+
+bool game_play(struct game_st *game, game_handler_f handler, u32 move) {
+  i32 x = move & 0xff;
+  i32 y = (move >> 8) & 0xff;
+  u32 action = (move >> 16) & 0xff;
+  bool hover =
+    action == 4 || ((action == 0 || action == 1) && (game->selx != x || game->sely != y));
+  if (hover && (x >= BOARD_W || y >= BOARD_H)) return false;
+  // the hover and the move it's for are undone together
+  journal_begin(game);
+  if (hover) game_hover(game, handler, x, y);
+  bool result = false;
+  switch (action) {
+    case 0: result = game_click(game, handler); break;
+    case 1: game_note(game, handler, (i8)(move >> 24)); result = true; break;
+    case 2: result = game_levelup(game, handler); break;
+    case 4: result = true; break;
+  }
+  journal_end(game);
+  return result;
+}
+
+static void replay_handler(struct game_st *game, enum game_event ev, i32 x, i32 y) {
+  // headless
+}
+
+bool game_replay(struct game_st *game, const struct movelog_st *log, const u8 *board, u32 *frames) {
+  game_new(game, log->difficulty, log->seed, board);
+  u32 pos = 0;
+  u32 stamp = 0;
+  while (pos < log->bits) {
+    u32 kind = movelog_get(log, &pos, 2);
+    i32 x = 0, y = 0;
+    if (kind != 2) {
+      x = movelog_get(log, &pos, MOVELOG_XBITS);
+      y = movelog_get(log, &pos, MOVELOG_YBITS);
+    }
+    i8 note = kind == 1 ? (i8)movelog_get(log, &pos, 5) - 3 : 0;
+    for (i32 shift = 0; ; shift += 3) {
+      stamp += movelog_get(log, &pos, 3) << shift;
+      if (!movelog_get(log, &pos, 1)) break;
+    }
+    switch (kind) {
+      case 0: game_play(game, replay_handler, H_CLICK(x, y)); break;
+      case 1: game_play(game, replay_handler, H_NOTE(x, y, note)); break;
+      case 2: game_play(game, replay_handler, H_LEVELUP()); break;
+      case 3: game_play(game, replay_handler, H_HOVER(x, y)); break;
+    }
+  }
+  *frames = stamp;
+  return !log->full;
+}
@@ -0,0 +1,442 @@
+//
+// cryptsweeper - fight the graveyard monsters and stop death
+// by Sean Connelly (@velipso), https://sean.fun
+// Project Home: https://github.com/velipso/cryptsweeper
+// SPDX-License-Identifier: 0BSD
+//
+
+//
+// This library is stand-alone so it can be called from either the GBA or xform at compile-time
+//
+
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "rnd.h"
+
+typedef uint8_t  u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t   i8;
+typedef int16_t  i16;
+typedef int32_t  i32;
+
+// host builds can pass -DBOARD_W=.. -DBOARD_H=.. to try other board sizes, up to 64x64
+#ifndef BOARD_W
+#define BOARD_W     14
+#define BOARD_H     9
+#endif
+#define BOARD_CW    (BOARD_W >> 1)
+#define BOARD_CH    (BOARD_H >> 1)
+#define BOARD_SIZE  (BOARD_W * BOARD_H)
+
+#if defined(SYS_GBA) && (BOARD_W != 14 || BOARD_H != 9)
+#error "the GBA screens are laid out for a 14x9 board"
+#endif
+_Static_assert(BOARD_W >= 8 && BOARD_W <= 64, "BOARD_W must be 8 to 64");
+_Static_assert(BOARD_H >= 7 && BOARD_H <= 64, "BOARD_H must be 7 to 64");
+
+#define GENERATE_SIZE  1024
+
+// levels.bin is GENERATE_SIZE groups of 6 boards (difficulty 0-4, then the only mines boards packed
+// as one bit per difficulty), with each board padded to LEVEL_STRIDE bytes
+#define LEVEL_STRIDE   ((BOARD_SIZE + 127) & ~127)
+#define GROUP_STRIDE   (LEVEL_STRIDE * 6)
+
+// bitplanes store one bit per cell, one row per element, where bit `x` of row `y` is cell (x, y)
+#if BOARD_W <= 16
+typedef u16 bitrow;
+#elif BOARD_W <= 32
+typedef u32 bitrow;
+#else
+typedef u64 bitrow;
+#endif
+typedef bitrow bitplane[BOARD_H];
+#define ROW_BIT(x)   ((bitrow)1 << (x))
+#define ROW_MASK     ((bitrow)(((u64)2 << (BOARD_W - 1)) - 1))
+
+// bit counting without __builtin_popcount/ctz/clz, which are libgcc calls on ARM7 (it has no clz
+// instruction), and popcount is one on x86 without -mpopcnt too
+static inline i32 popcount(u32 v) {
+  v = v - ((v >> 1) & 0x55555555);
+  v = (v & 0x33333333) + ((v >> 2) & 0x33333333);
+  v = (v + (v >> 4)) & 0x0f0f0f0f;
+  return (v * 0x01010101) >> 24;
+}
+
+// index of the lowest set bit, v can't be 0
+static inline i32 bit_ctz(u32 v) {
+  return popcount((v & -v) - 1);
+}
+
+// index of the highest set bit, v can't be 0
+static inline i32 bit_top(u32 v) {
+  v |= v >> 1;
+  v |= v >> 2;
+  v |= v >> 4;
+  v |= v >> 8;
+  v |= v >> 16;
+  return popcount(v) - 1;
+}
+
+static inline i32 row_ctz(bitrow row) {
+  if (sizeof(bitrow) > 4 && (u32)row == 0) return 32 + bit_ctz((u32)((u64)row >> 32));
+  return bit_ctz((u32)row);
+}
+
+enum game_plane {
+  // status of the tile, indexed by S_*
+  P_HIDDEN,
+  P_VISIBLE,
+  P_PRESSED,
+  P_KILLED,
+  // type classes
+  P_EMPTY,   // T_EMPTY or T_LAVA
+  P_MONSTER,
+  P_MINE,
+  P_WALL,
+  P_CHEST,
+  P_LV5C,    // witches hide threat around them
+  // monster level, bit-sliced, so threat = P_LEVEL1 + 2 * P_LEVEL2 + 4 * P_LEVEL4 + 8 * P_LEVEL8
+  P_LEVEL1,
+  P_LEVEL2,
+  P_LEVEL4,
+  P_LEVEL8,
+  // hidden tile has a note on it (notes != -3)
+  P_NOTED,
+  P__SIZE
+};
+
+struct game_st {
+  struct rnd_st rnd;
+  u32 totalexp;
+  i8 selx;
+  i8 sely;
+  u8 difficulty;
+  u8 version; // board shuffle used by game_new, see D_VERSION1
+  u8 level;
+  u8 hp;
+  u8 exp;
+  u8 win; // 0 = play, 1 = dead, 2 = win
+  struct {
+    i8 size;
+    u8 x[4];
+    u8 y[4];
+  } mummy;
+  u8 losthp;
+  i8 notes[BOARD_SIZE];
+  u8 board[BOARD_SIZE];
+  // SSTT:TTTT
+  // where SS is status:
+  //   00 - unpressed, hidden
+  //   01 - unpressed, visible
+  //   10 - pressed (if not empty, then collectable)
+  //   11 - killed (the tile has killed the player)
+  // and TT is type (0-63)
+  bitplane planes[P__SIZE]; // kept in sync with board/notes, see game_sync
+  u16 threat[BOARD_SIZE];   // cached threat of the neighbors of each cell (0x100 per mine)
+  bitplane witched;         // cells in range of a lv5c, where threat is hidden
+  struct {
+    // game_hint's deductions, updated lazily from the cells marked stale by board/note changes
+    bitplane stale;           // remain needs recalculating
+    bitplane stale_could;     // could needs recalculating
+    i16 remain[BOARD_SIZE];   // pressed empty cells: threat not explained by known neighbors
+    u16 could[BOARD_SIZE];    // threats a cell could have: bit n for threat n (1-11), bit 12 for mine
+  } solver;
+  u64 hash;                 // zobrist hash of board, notes, hp, exp and level, see game_zobrist
+  bitplane dirty;           // changed tiles waiting for game_flush
+  bool batch;               // mark changed tiles dirty instead of sending EV_TILE_UPDATE
+  struct journal_st *journal; // records actions for game_undo, or NULL, see game_journal
+};
+
+// bytes at the start of game_st that hold the game itself; everything after them is a cache that
+// game_sync rebuilds, or only matters while the game is running, so saves can leave them out
+#define GAME_STATE_SIZE  offsetof(struct game_st, planes)
+
+// compact record of a run, enough for game_replay to play it back exactly
+//
+// each entry is packed into data, lowest bit first:
+//   2 bits: kind (0 = click, 1 = note, 2 = levelup, 3 = hover)
+//   4+4 bits: x, y (not for levelup; more on boards over 16 wide or tall)
+//   5 bits: note + 3 (only for notes)
+//   frames since the previous entry, 3 bits at a time, each followed by a bit that says if more
+//   follow
+// clicks and notes are on the cell they name, so hovers are only recorded when they land on lava,
+// which is the only time a hover changes anything
+#define MOVELOG_SIZE   2048
+struct movelog_st {
+  u32 seed;       // as passed to game_new
+  u32 frames;     // timed frames so far (each adds 280896 cycles to the clock)
+  u32 last;       // frames at the last entry
+  u16 bits;       // bits of data used
+  u8 difficulty;  // as passed to game_new
+  u8 full;        // stopped recording, because it ran out of room or can't be replayed
+  u8 data[MOVELOG_SIZE];
+};
+
+// undo history, as the bytes of game_st each action changed and what they were before
+//
+// every entry is (offset in game_st << 8) | old byte, and each action starts with JOURNAL_MARK;
+// board and note writes are recorded as they happen, and the fields before the notes are compared
+// against their value at the start of the action once it's done, so only changed bytes are kept;
+// when the ring fills up, the oldest actions are forgotten to make room
+#define JOURNAL_SIZE   1024
+#define JOURNAL_MARK   0xffffffff
+#define JOURNAL_HEAD   offsetof(struct game_st, notes)
+struct journal_st {
+  u16 head;       // next entry to write
+  u16 used;       // entries in the ring, ending at head
+  u16 actions;    // finished actions that can be undone
+  u8 depth;       // nested actions in progress, only the outermost one is recorded
+  u8 lost;        // the action in progress didn't fit, so it won't be recorded
+  u8 start[JOURNAL_HEAD]; // fields before the notes at the start of the action
+  u32 entries[JOURNAL_SIZE];
+};
+
+// difficulty flags
+#define D_DIFFICULTY   0x0f
+#define D_ONLYMINES    0x10
+// passed to game_new to select the single pass shuffle, stored in game->version instead of
+// game->difficulty, so old seeds still make the same boards
+#define D_VERSION1     0x20
+
+// tile types
+enum game_type {
+  T_EMPTY     ,
+  T_LAVA      ,
+  T_LV1A      , /* spider */
+  T_LV1B      , /* mummy */
+  T_LV2       ,
+  T_LV3A      , /* normal */
+  T_LV3B      , /* group 2 */
+  T_LV3C      , /* group 3 */
+  T_LV4A      , /* rook */
+  T_LV4B      , /* bishop */
+  T_LV4C      , /* knight */
+  T_LV5A      , /* beetle */
+  T_LV5B      , /* big spider */
+  T_LV5C      , /* swamp witch */
+  T_LV6       ,
+  T_LV7       ,
+  T_LV8       ,
+  T_LV9       ,
+  T_LV10      ,
+  T_LV11      , /* mimic */
+  T_LV13      ,
+  T_MINE      ,
+  T_WALL      ,
+  // chests:
+  T_CHEST_HEAL,
+  T_CHEST_EYE2,
+  T_CHEST_EXP ,
+  // items:
+  T_ITEM_HEAL ,
+  T_ITEM_EYE  ,
+  T_ITEM_EYE2 ,
+  T_ITEM_SHOW1,
+  T_ITEM_SHOW5,
+  T_ITEM_EXP1 ,
+  T_ITEM_EXP3 ,
+  T_ITEM_EXP5 ,
+  T_ITEM_EXP6 ,
+  T_ITEM_EXP9 ,
+  T_ITEM_LV3B0,
+  T_ITEM_LV3C0,
+  T_ITEM_LAVA ,
+  T_ITEM_EXIT
+  // max of 63
+};
+#define T__SIZE  (T_ITEM_EXIT + 1)
+
+// tile flags
+#define TF_EMPTY      0x01
+#define TF_MONSTER    0x02
+#define TF_CHEST      0x04
+#define TF_ITEM       0x08
+
+// what happens when a tile is collected or attacked
+enum game_tile_action {
+  TA_NONE,
+  TA_MONSTER, // collecting awards exp and leaves reward behind
+  TA_GROUP,   // like TA_MONSTER, but attacking leaves group[0] behind, or group[1] if it's the last
+  TA_MINE,
+  TA_WALL,
+  TA_CHEST,   // leaves reward behind
+  TA_HEAL,
+  TA_EYE,
+  TA_EYE2,
+  TA_SHOW1,
+  TA_SHOW5,
+  TA_EXP,     // awards value exp
+  TA_REJECT,
+  TA_LAVA,
+  TA_EXIT
+};
+
+// everything static about a tile type, indexed by enum game_type
+struct game_tile_st {
+  u16 icon;
+  u16 threat;   // added to each neighbor (0x100 for mines), also exp for killing a monster
+  u8 flags;     // TF_*
+  u8 action;    // TA_*
+  u8 grunt;     // SFX_* when attacked
+  u8 reward;    // type left behind after collecting
+  u8 value;
+  u8 group[2];
+};
+
+extern const struct game_tile_st game_tiles[];
+
+// tile status
+#define S_HIDDEN      0
+#define S_VISIBLE     1
+#define S_PRESSED     2
+#define S_KILLED      3
+
+#define GET_TYPE(b)               ((enum game_type)((b) & 0x3f))
+#define GET_TYPEXY(b, x, y)       GET_TYPE((b)[(x) + (y) * BOARD_W])
+#define SET_TYPE(b, t)            b = ((b) & 0xc0) | (t)
+#define SET_TYPEXY(b, x, y, t)    do { i32 k = (x) + (y) * BOARD_W; SET_TYPE(b[k], t); } while (0)
+#define GET_STATUS(b)             (((b) >> 6) & 3)
+#define GET_STATUSXY(b, x, y)     GET_STATUS((b)[(x) + (y) * BOARD_W])
+#define SET_STATUS(b, s)          b = GET_TYPE(b) | ((s) << 6)
+#define SET_STATUSXY(b, x, y, s)  do { i32 k = (x) + (y) * BOARD_W; SET_STATUS(b[k], s); } while (0)
+#define TILE_FLAGS(b)             (game_tiles[GET_TYPE(b)].flags)
+#define IS_EMPTY(b)               ((TILE_FLAGS(b) & TF_EMPTY) != 0)
+#define IS_EMPTYXY(b, x, y)       IS_EMPTY((b)[(x) + (y) * BOARD_W])
+#define IS_MONSTER(b)             ((TILE_FLAGS(b) & TF_MONSTER) != 0)
+#define IS_CHEST(b)               ((TILE_FLAGS(b) & TF_CHEST) != 0)
+#define IS_CHESTXY(b, x, y)       IS_CHEST((b)[(x) + (y) * BOARD_W])
+#define IS_ITEM(b)                ((TILE_FLAGS(b) & TF_ITEM) != 0)
+#define IS_ITEMXY(b, x, y)        IS_ITEM((b)[(x) + (y) * BOARD_W])
+#define PLANE_GET(p, x, y)        (((p)[y] >> (x)) & 1)
+#define PLANE_SET(p, x, y)        (p)[y] |= ROW_BIT(x)
+
+enum game_event {
+  EV_PRESS_EMPTY, // (x, y) tile location where pressing empty
+  EV_TILE_UPDATE, // (x, y) tile location
+  EV_HP_UPDATE,   // (hp, max_hp)
+  EV_EXP_UPDATE,  // (exp, max_exp)
+  EV_SHOW_LAVA,
+  EV_HOVER_LAVA,
+  EV_YOU_LOSE,    // (x, y) tile that killed you
+  EV_YOU_WIN,
+  EV_WAIT,        // wait x number of frames
+  EV_SFX,         // (index)
+  EV_DEBUGLOG     // (id, value)
+};
+
+enum game_event_sfx {
+  SFX_BUMP,
+  SFX_EYE,
+  SFX_CHEST,
+  SFX_WALL,
+  SFX_EXP1,
+  SFX_EXP2,
+  SFX_GRUNT1,
+  SFX_GRUNT2,
+  SFX_GRUNT3,
+  SFX_GRUNT4,
+  SFX_GRUNT5,
+  SFX_GRUNT6,
+  SFX_GRUNT7,
+  SFX_EXIT,
+  SFX_HEART,
+  SFX_MINE,
+  SFX_DIRT,
+  SFX_REJECT
+};
+
+// how game_hint scores a monster worth challenging, in points
+struct hint_weights_st {
+  i32 unknown; // for a cell whose threat isn't known yet
+  i32 threat;  // per threat level
+  i32 bias;    // added to the threat level before scaling
+  i32 lv3;     // threat levels a lv3 counts as, with knowledge bit 2
+  i32 lv10;    // threat levels a lv10 counts as, with knowledge bit 8
+  i32 witch;   // per witch gazing at the cell
+  i32 hidden;  // per hidden neighbor
+};
+
+extern const struct hint_weights_st hint_weights_default;
+
+typedef void (*game_handler_f)(struct game_st *game, enum game_event ev, i32 x, i32 y);
+
+// moves, as returned by game_hint and recorded by movelog_add; byte 0: x, byte 1: y, byte 2: action
+// (click, note, levelup, giveup, hover), byte 3: note value
+#define H_CLICK(x, y)    (0x00000000 | (x) | ((y) << 8))
+#define H_NOTE(x, y, n)  (0x00010000 | (x) | ((y) << 8) | (((u8)n) << 24))
+#define H_LEVELUP()      0x00020000
+#define H_GIVEUP()       0x00030000
+#define H_HOVER(x, y)    (0x00040000 | (x) | ((y) << 8))
+
+void game_new(struct game_st *game, i32 difficulty, u32 seed, const u8 *board);
+// start recording every action into journal (emptied first), or stop if NULL; game_new stops it,
+// and copies of the game share the journal, so detach them before playing them; changes made
+// between actions, like game_hint's, aren't recorded; on the GBA the journal belongs in EWRAM
+void game_journal(struct game_st *game, struct journal_st *journal);
+// reverse the last recorded action, sending events for what changed back; returns false if there
+// is nothing left to undo
+bool game_undo(struct game_st *game, game_handler_f handler);
+void game_hover(struct game_st *game, game_handler_f handler, i32 x, i32 y);
+bool game_click(struct game_st *game, game_handler_f handler);
+bool game_levelup(struct game_st *game, game_handler_f handler);
+void game_note(struct game_st *game, game_handler_f handler, i8 note);
+void game_flush(struct game_st *game, game_handler_f handler);
+i32 game_tileicon(u32 type);
+i32 max_hp(struct game_st *game);
+bool next_level_hp_increases(struct game_st *game);
+i32 max_exp(struct game_st *game);
+i32 count_threat(const u8 *board, i32 x, i32 y);
+i32 game_count_threat(struct game_st *game, i32 x, i32 y);
+void game_sync(struct game_st *game);
+u64 game_zobrist(const struct game_st *game);
+// swap two cells (index x + y * BOARD_W) with caches kept in sync, for tools that search over what
+// could be hidden
+void game_swap(struct game_st *game, i32 a, i32 b);
+void planes_build(bitplane *planes, const u8 *board);
+i32 plane_count(const bitrow *plane, i32 x, i32 y, i32 rad);
+// the next move to make (H_* encoding), using what the knowledge bits allow it to know
+i32 game_hint(struct game_st *game, game_handler_f handler, i32 knowledge);
+// game_hint with other scoring weights, for tuning them
+i32 game_hint_weighted(
+  struct game_st *game,
+  game_handler_f handler,
+  i32 knowledge,
+  const struct hint_weights_st *weights
+);
+// game_hint(game, handler, -1) spread over as many calls as it takes, so it can be worked on a bit
+// each frame, and kept until the board changes
+struct hint_job_st {
+  u64 hash;     // game->hash the job is for
+  i32 result;   // the hint, once the job is done
+  u16 next;     // next cell to find the witch evidence of
+  u8 stage;     // 0 = not started, 1 = solver, 2 = witches, 3 = done
+  i16 witches[BOARD_SIZE];
+};
+// forget the job's progress and result; a job must start cancelled
+void game_hint_cancel(struct hint_job_st *job);
+// do about budget cells worth of the job, returning true when job->result holds the hint; asking
+// again before the board changes is free, and a changed board starts the job over
+bool game_hint_step(
+  struct game_st *game,
+  game_handler_f handler,
+  struct hint_job_st *job,
+  i32 budget
+);
+// fills queue with every risk-free click/note available now (same encoding as game_hint), so
+// they can be played back without a board scan each; size of BOARD_SIZE is always enough
+i32 game_forced(struct game_st *game, u32 *queue, i32 size);
+// check a queued hint before playing it, in case the board changed since
+bool game_forced_valid(struct game_st *game, u32 hint);
+void movelog_start(struct movelog_st *log, i32 difficulty, u32 seed);
+// record a move (H_* encoding) before it's played, stamped with the frames since the last one
+void movelog_add(struct movelog_st *log, u32 move);
+// play a move (H_* encoding), hovering first if it's on a cell that isn't selected; returns false
+// if the move did nothing, like a bumped click or a give up
+bool game_play(struct game_st *game, game_handler_f handler, u32 move);
+// plays the log back without any events, leaving the final state in game and the frame stamp of
+// the last move in frames; returns false if the log isn't complete
+bool game_replay(struct game_st *game, const struct movelog_st *log, const u8 *board, u32 *frames);
@@ -0,0 +1,110 @@
+//
+// cryptsweeper - fight the graveyard monsters and stop death
+// by Pocket Pulp (@velipso), https://pulp.biz
+// Project Home: https://github.com/velipso/cryptsweeper
+// SPDX-License-Identifier: 0BSD
+//
+
+//
+// Times the engine's hot spots at whatever board size this was compiled for, see `make bench`.
+// Everything is normalized by board area, so a number that climbs with the size is a loop that
+// grows faster than the board does.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "generate.h"
+
+#define BENCH_BOARDS  16
+
+static void handler(struct game_st *game, enum game_event ev, i32 x, i32 y) {
+  // do nothing
+}
+
+static double now() {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+int main(int argc, const char **argv) {
+  double budget = argc >= 2 ? atof(argv[1]) : 1;
+  struct rnd_st rnd;
+  rnd_seed(&rnd, 1);
+  static u8 boards[BENCH_BOARDS][BOARD_SIZE];
+
+  // generate_full
+  i32 generated = 0;
+  double start = now();
+  double elapsed;
+  do {
+    generate_full(boards[generated % BENCH_BOARDS], generated % 5, &rnd, NULL);
+    generated++;
+    elapsed = now() - start;
+  } while (elapsed < budget || generated < BENCH_BOARDS);
+  double gen_us = elapsed * 1e6 / generated;
+
+  // count_threat over every cell
+  u64 cells = 0;
+  i32 sum = 0;
+  start = now();
+  do {
+    for (i32 b = 0; b < BENCH_BOARDS; b++) {
+      for (i32 y = 0; y < BOARD_H; y++) {
+        for (i32 x = 0; x < BOARD_W; x++) {
+          sum += count_threat(boards[b], x, y);
+        }
+      }
+    }
+    cells += BENCH_BOARDS * BOARD_SIZE;
+    elapsed = now() - start;
+  } while (elapsed < budget);
+  double threat_ns = elapsed * 1e9 / cells;
+
+  // game_hint with full knowledge, with the forced moves in between like play_game
+  u64 hints = 0;
+  u64 moves = 0;
+  i32 games = 0;
+  i32 wins = 0;
+  double hint_time = 0;
+  start = now();
+  do {
+    struct game_st game;
+    game_new(&game, (games % 5) | D_VERSION1, games + 1, boards[games % BENCH_BOARDS]);
+    while (game.win == 0) {
+      u32 forced[BOARD_SIZE];
+      i32 count = game_forced(&game, forced, BOARD_SIZE);
+      i32 played = 0;
+      for (i32 i = 0; i < count; i++) {
+        if (game_forced_valid(&game, forced[i])) {
+          game_play(&game, handler, forced[i]);
+          played++;
+        }
+      }
+      moves += played;
+      if (played > 0) continue;
+      double t = now();
+      u32 hint = game_hint(&game, handler, -1);
+      hint_time += now() - t;
+      hints++;
+      moves++;
+      if (!game_play(&game, handler, hint) && ((hint >> 16) & 0xff) == 3) break;
+    }
+    wins += game.win == 2;
+    games++;
+    elapsed = now() - start;
+  } while (elapsed < budget || games < 5);
+  double hint_us = hints ? hint_time * 1e6 / hints : 0;
+
+  printf(
+    "%2dx%-2d %5d cells | generate_full %9.1f us/board %7.1f ns/cell | count_threat %5.1f ns"
+    " | game_hint %8.2f us %6.1f ns/cell (%llu hints, %d games, %d won, %.0f moves/game)\n",
+    BOARD_W, BOARD_H, BOARD_SIZE,
+    gen_us, gen_us * 1000 / BOARD_SIZE,
+    threat_ns,
+    hint_us, hint_us * 1000 / BOARD_SIZE,
+    (unsigned long long)hints, games, wins, (double)moves / games
+  );
+  return sum == 0x7fffffff; // keep count_threat from being optimized away
+}
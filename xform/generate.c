@@ -7,7 +7,12 @@
 
 #include <stdio.h>
 #include <stdbool.h>
+#include <time.h>
 #include "generate.h"
+#include "pool.h"
+
+// piece counts below are for the 14x9 board, and keep the same density on other sizes
+#define SCALED(n)  ((n) * BOARD_SIZE / (14 * 9))
 
 static void print_board(const u8 *board) {
   for (i32 y = 0, k = 0; y < BOARD_H; y++) {
@@ -54,8 +59,8 @@ static void print_board(const u8 *board) {
 }
 
 static void generate_onlymines(u8 *board, i32 diff, struct rnd_st *rnd) {
-  u8 minecount_table[] = { 16, 18, 20, 22, 26 };
-  u8 minecount = minecount_table[diff];
+  static const u8 minecount_table[] = { 16, 18, 20, 22, 26 };
+  i32 minecount = SCALED(minecount_table[diff]);
   for (;;) {
     // place mines in empty board
     for (i32 i = 0; i < BOARD_SIZE; i++) {
@@ -173,22 +178,10 @@ static void generate_onlymines(u8 *board, i32 diff, struct rnd_st *rnd) {
 
 typedef bool (*istile_f)(u8 tile);
 
-static bool istile_wall(u8 tile) {
-  return GET_TYPE(tile) == T_WALL;
-}
-
-static bool istile_chest(u8 tile) {
-  return IS_CHEST(tile);
-}
-
 static bool istile_chest_heal(u8 tile) {
   return GET_TYPE(tile) == T_CHEST_HEAL;
 }
 
-static bool istile_mine(u8 tile) {
-  return GET_TYPE(tile) == T_MINE;
-}
-
 static bool istile_lv6(u8 tile) {
   return GET_TYPE(tile) == T_LV6;
 }
@@ -246,11 +239,62 @@ static void copy_board(u8 *dst, const u8 *src) {
   }
 }
 
-static void generate_full(u8 *board, i32 diff, struct rnd_st *rnd) {
+// narrow starts down to the cells the start location could still go in: an empty cell with exactly
+// one wall, one chest (with healing in it, once chests are placed), no mines and nothing lv5b or
+// higher around it; later pieces only ever add to what's around a cell, so once a cell fails it
+// never passes, and a board with no cells left can be thrown away without placing the rest
+//
+// the one exception is easy's extra heal chest, which comes with the last pieces and can give a
+// cell with no chests around it the one it needs, so `spare_heal` keeps those cells
+static bool narrow_starts(
+  const u8 *board,
+  const bitrow *walls,
+  const bitrow *mines,
+  const bitrow *chests, // NULL before the chests are placed
+  bool spare_heal,
+  bitrow *starts
+) {
+  bool found = false;
+  for (i32 y = 0; y < BOARD_H; y++) {
+    for (bitrow row = starts[y]; row; row &= row - 1) {
+      i32 x = row_ctz(row);
+      if (
+        IS_EMPTYXY(board, x, y) &&
+        plane_count(walls, x, y, -2) == 1 &&
+        plane_count(mines, x, y, -2) == 0 &&
+        count_tiles(board, x, y, -2, istile_lv5bplus) == 0 && (
+          chests == NULL || (
+            plane_count(chests, x, y, -2) == 1 &&
+            count_tiles(board, x, y, -2, istile_chest_heal) == 1
+          ) || (
+            spare_heal && plane_count(chests, x, y, -2) == 0
+          )
+        )
+      ) {
+        found = true;
+      } else {
+        starts[y] &= ~ROW_BIT(x);
+      }
+    }
+  }
+  return found;
+}
+
+void generate_full(u8 *board, i32 diff, struct rnd_st *rnd, struct generate_stats_st *stats) {
+  // bitplanes of the walls, mines, and chests placed so far, and where the game could start
+  bitplane walls, mines, chests, starts;
+  enum generate_stage stage = GS__SIZE; // why the last try started over
+  #define RESTART(s)  do { stage = (s); goto restart; } while (0)
 restart:
+  if (stats && stage != GS__SIZE) stats->restarts[stage]++;
   for (i32 i = 0; i < BOARD_SIZE; i++) {
     board[i] = 0;
   }
+  for (i32 y = 0; y < BOARD_H; y++) {
+    walls[y] = mines[y] = chests[y] = 0;
+    starts[y] = y >= 2 && y < BOARD_H - 2 ? ROW_MASK & ~(ROW_BIT(0) | ROW_BIT(1)) &
+      ~(ROW_BIT(BOARD_W - 2) | ROW_BIT(BOARD_W - 1)) : 0;
+  }
 
   { // lv13 is in the center
     i32 x = roll(rnd, 2) + BOARD_CW - 1;
@@ -305,7 +349,7 @@ restart:
     }
   }
 
-  for (i32 i = 0; i < 3; i++) { // walls come in pairs
+  for (i32 i = 0; i < SCALED(3); i++) { // walls come in pairs
     for (;;) {
       i32 x1, y1, x2, y2;
       if (roll(rnd, 2)) { // vertical
@@ -320,11 +364,13 @@ restart:
       if (
         IS_EMPTYXY(board, x1, y1) &&
         IS_EMPTYXY(board, x2, y2) &&
-        count_tiles(board, x1, y1, 2, istile_wall) == 0 &&
-        count_tiles(board, x2, y2, 2, istile_wall) == 0
+        plane_count(walls, x1, y1, 2) == 0 &&
+        plane_count(walls, x2, y2, 2) == 0
       ) {
         SET_TYPEXY(board, x1, y1, T_WALL);
         SET_TYPEXY(board, x2, y2, T_WALL);
+        PLANE_SET(walls, x1, y1);
+        PLANE_SET(walls, x2, y2);
         break;
       }
     }
@@ -356,7 +402,7 @@ restart:
       SET_TYPEXY(board, x2, y2, T_LV7);
       break;
     }
-    if (attempt > 100) goto restart;
+    if (attempt > 100) RESTART(GS_LV7);
   }
 
   i32 lv4mask = 7;
@@ -367,7 +413,7 @@ restart:
     case 3: lv4mask = 7; break; // all types
     case 4: lv4mask = roll(rnd, 2) + 5; break; // only rooks+knights, or only bishops+knights
   }
-  for (i32 i = 0; i < 4; i++) { // four pairs of lv4's in formation
+  for (i32 i = 0; i < SCALED(4); i++) { // four pairs of lv4's in formation
     for (i32 attempt = 0; ; attempt++) {
       i32 x1, y1, x2, y2, t;
       i32 kind;
@@ -427,41 +473,46 @@ restart:
         SET_TYPEXY(board, x2, y2, t);
         break;
       }
-      if (attempt > 100) goto restart;
+      if (attempt > 100) RESTART(GS_LV4);
     }
   }
 
-  for (i32 i = 0; i < 9; i++) { // place mines such that there aren't more than 4 threating a square
+  // place mines such that there aren't more than 4 threating a square
+  for (i32 i = 0; i < SCALED(9); i++) {
     for (i32 attempt = 0; ; attempt++) {
       i32 x = roll(rnd, BOARD_W);
       i32 y = roll(rnd, BOARD_H);
       if (
         IS_EMPTYXY(board, x, y) &&
-        count_tiles(board, x - 1, y - 1, 1, istile_mine) < 4 &&
-        count_tiles(board, x    , y - 1, 1, istile_mine) < 4 &&
-        count_tiles(board, x + 1, y - 1, 1, istile_mine) < 4 &&
-        count_tiles(board, x - 1, y    , 1, istile_mine) < 4 &&
-        count_tiles(board, x + 1, y    , 1, istile_mine) < 4 &&
-        count_tiles(board, x - 1, y + 1, 1, istile_mine) < 4 &&
-        count_tiles(board, x    , y + 1, 1, istile_mine) < 4 &&
-        count_tiles(board, x + 1, y + 1, 1, istile_mine) < 4
+        plane_count(mines, x - 1, y - 1, 1) < 4 &&
+        plane_count(mines, x    , y - 1, 1) < 4 &&
+        plane_count(mines, x + 1, y - 1, 1) < 4 &&
+        plane_count(mines, x - 1, y    , 1) < 4 &&
+        plane_count(mines, x + 1, y    , 1) < 4 &&
+        plane_count(mines, x - 1, y + 1, 1) < 4 &&
+        plane_count(mines, x    , y + 1, 1) < 4 &&
+        plane_count(mines, x + 1, y + 1, 1) < 4
       ) {
         SET_TYPEXY(board, x, y, T_MINE);
+        PLANE_SET(mines, x, y);
         break;
       }
-      if (attempt > 100) goto restart;
+      if (attempt > 100) RESTART(GS_MINES);
     }
   }
 
-  for (i32 i = 0; i < 11; i++) { // place chests and lv6
+  // most boards have nowhere to start by now, so don't bother with them any further
+  if (!narrow_starts(board, walls, mines, NULL, false, starts)) RESTART(GS_NOSTART_MINES);
+
+  for (i32 i = 0; i < SCALED(11); i++) { // place chests and lv6
     for (i32 attempt = 0; ; attempt++) {
       i32 x = roll(rnd, BOARD_W);
       i32 y = roll(rnd, BOARD_H);
       if (
         IS_EMPTYXY(board, x, y) &&
-        count_tiles(board, x, y, 2, istile_chest) < 2
+        plane_count(chests, x, y, 2) < 2
       ) {
-        if (i < 6) {
+        if (i < SCALED(6)) {
           // place lv6 near chest
           i32 x2 = x + roll(rnd, 3) - 1;
           i32 y2 = y + roll(rnd, 3) - 1;
@@ -479,74 +530,83 @@ restart:
           }
           SET_TYPEXY(board, x2, y2, T_LV6);
         }
-        SET_TYPEXY(board, x, y, i == 0 ? T_CHEST_EYE2 : i < 4 ? T_CHEST_EXP : T_CHEST_HEAL);
+        SET_TYPEXY(
+          board, x, y,
+          i == 0 ? T_CHEST_EYE2 : i < SCALED(4) ? T_CHEST_EXP : T_CHEST_HEAL
+        );
+        PLANE_SET(chests, x, y);
         break;
       }
-      if (attempt > 100) goto restart;
+      if (attempt > 100) RESTART(GS_CHESTS);
     }
   }
 
+  if (!narrow_starts(board, walls, mines, chests, diff == 0, starts)) RESTART(GS_NOSTART_CHESTS);
+
   // last pieces
   u8 copy[BOARD_SIZE];
   copy_board(copy, board);
   for (i32 attempt = 0; ; attempt++) {
     // place the rest randomly
-    place_random(board, rnd, T_LV5B,  1); // big spider
-    place_random(board, rnd, T_LV1A, 12);
-    place_random(board, rnd, T_LV2 , 11);
+    place_random(board, rnd, T_LV5B, SCALED(1)); // big spider
+    place_random(board, rnd, T_LV1A, SCALED(12));
+    place_random(board, rnd, T_LV2 , SCALED(11));
     switch (diff) {
       case 0:
         // no witch (scarab instead)
         // no mimics (extra chest heal instead)
-        place_random(board, rnd, T_CHEST_HEAL, 1);
-        place_random(board, rnd, T_LV5A, 10); // scarab
-        place_random(board, rnd, T_LV3A,  9); // immediate exp
+        place_random(board, rnd, T_CHEST_HEAL, SCALED(1));
+        place_random(board, rnd, T_LV5A, SCALED(10)); // scarab
+        place_random(board, rnd, T_LV3A, SCALED(9)); // immediate exp
         break;
       case 1:
         // no mimics (scarab instead)
-        place_random(board, rnd, T_LV5A, 10); // scarab
-        place_random(board, rnd, T_LV5C,  1); // witch
-        place_random(board, rnd, T_LV3A,  9); // immediate exp
+        place_random(board, rnd, T_LV5A, SCALED(10)); // scarab
+        place_random(board, rnd, T_LV5C, SCALED(1)); // witch
+        place_random(board, rnd, T_LV3A, SCALED(9)); // immediate exp
         break;
       case 2:
-        place_random(board, rnd, T_LV11, 1); // mimic
-        place_random(board, rnd, T_LV5A, 8); // scarab
-        place_random(board, rnd, T_LV5C, 2); // witch
-        place_random(board, rnd, T_LV3A, 9); // immediate exp
+        place_random(board, rnd, T_LV11, SCALED(1)); // mimic
+        place_random(board, rnd, T_LV5A, SCALED(8)); // scarab
+        place_random(board, rnd, T_LV5C, SCALED(2)); // witch
+        place_random(board, rnd, T_LV3A, SCALED(9)); // immediate exp
         break;
       case 3:
-        place_random(board, rnd, T_LV11, 1); // mimic
-        place_random(board, rnd, T_LV5A, 8); // scarab
-        place_random(board, rnd, T_LV5C, 2); // witch
-        place_random(board, rnd, T_LV3A, 7); // immediate exp
-        place_random(board, rnd, T_LV3B, 2); // delayed exp (group 2)
+        place_random(board, rnd, T_LV11, SCALED(1)); // mimic
+        place_random(board, rnd, T_LV5A, SCALED(8)); // scarab
+        place_random(board, rnd, T_LV5C, SCALED(2)); // witch
+        place_random(board, rnd, T_LV3A, SCALED(7)); // immediate exp
+        place_random(board, rnd, T_LV3B, SCALED(2)); // delayed exp (group 2)
         break;
       case 4:
-        place_random(board, rnd, T_LV11, 1); // mimic
-        place_random(board, rnd, T_LV5A, 8); // scarab
-        place_random(board, rnd, T_LV5C, 2); // witch
-        place_random(board, rnd, T_LV3A, 4); // immediate exp
-        place_random(board, rnd, T_LV3B, 2); // delayed exp (group 2)
-        place_random(board, rnd, T_LV3C, 3); // delayed exp (group 3)
+        place_random(board, rnd, T_LV11, SCALED(1)); // mimic
+        place_random(board, rnd, T_LV5A, SCALED(8)); // scarab
+        place_random(board, rnd, T_LV5C, SCALED(2)); // witch
+        place_random(board, rnd, T_LV3A, SCALED(4)); // immediate exp
+        place_random(board, rnd, T_LV3B, SCALED(2)); // delayed exp (group 2)
+        place_random(board, rnd, T_LV3C, SCALED(3)); // delayed exp (group 3)
         break;
     }
     // final placement is the starting location, which should reveal certain things
+    bitplane startchests; // includes any chests from place_random
+    for (i32 y = 0, k = 0; y < BOARD_H; y++) {
+      startchests[y] = 0;
+      for (i32 x = 0; x < BOARD_W; x++, k++) {
+        if (IS_CHEST(board[k])) PLANE_SET(startchests, x, y);
+      }
+    }
     i32 bx = -1;
     i32 by = -1;
     i32 found = 0;
-    for (i32 y = 2; y < BOARD_H - 2; y++) {
-      for (i32 x = 2; x < BOARD_W - 2; x++) {
+    for (i32 y = 0; y < BOARD_H; y++) {
+      for (bitrow row = starts[y]; row; row &= row - 1) {
+        i32 x = row_ctz(row);
         if (
+          // the rest of the checks passed in narrow_starts, and the pieces just placed can't be on
+          // it or around it; a cell easy kept with no chests can only have gained the heal chest
           IS_EMPTYXY(board, x, y) &&
-          // don't reveal big spider or higher
-          count_tiles(board, x, y, -2, istile_lv5bplus) == 0 &&
-          // exactly one wall
-          count_tiles(board, x, y, -2, istile_wall) == 1 &&
-          // exactly one chest with healing in it
-          count_tiles(board, x, y, -2, istile_chest) == 1 &&
-          count_tiles(board, x, y, -2, istile_chest_heal) == 1 &&
-          // no mines
-          count_tiles(board, x, y, -2, istile_mine) == 0
+          plane_count(startchests, x, y, -2) == 1 &&
+          count_tiles(board, x, y, -2, istile_lv5bplus) == 0
         ) {
           if (rnd_pick(rnd, found)) {
             bx = x;
@@ -561,163 +621,360 @@ restart:
       SET_STATUSXY(board, bx, by, S_PRESSED);
       break;
     }
-    if (attempt > 100) goto restart;
+    if (attempt > 100) RESTART(GS_START);
     // we've come so far... let's not start completely over, just try again
     copy_board(board, copy);
   }
+  #undef RESTART
 }
 
 static void handler(struct game_st *game, enum game_event ev, i32 x, i32 y) {
   // do nothing?
 }
 
-static i32 play_game(struct game_st *game, i32 diff, u32 seed, const u8 *board, i32 knowledge) {
-  game_new(game, diff, seed, board);
-  i32 iter = 0;
-  while (game->win == 0) {
-    iter++;
-    i32 hint = game_hint(game, handler, knowledge);
-    u8 x = hint & 0xff;
-    u8 y = (hint >> 8) & 0xff;
-    u8 action = (hint >> 16) & 0xff;
-    i8 note = (hint >> 24) & 0xff;
-    switch (action) {
-      case 0: // click
-        game_hover(game, handler, x, y);
-        if (!game_click(game, handler)) {
-          fprintf(stderr, "WARNING: bad click!\n");
-        }
-        break;
-      case 1: { // note
-        game_hover(game, handler, x, y);
-        game_note(game, handler, note);
-        break;
+// returns false if the game should stop
+static bool play_hint(struct game_st *game, i32 hint) {
+  u8 x = hint & 0xff;
+  u8 y = (hint >> 8) & 0xff;
+  u8 action = (hint >> 16) & 0xff;
+  i8 note = (hint >> 24) & 0xff;
+  switch (action) {
+    case 0: // click
+      game_hover(game, handler, x, y);
+      if (!game_click(game, handler)) {
+        fprintf(stderr, "WARNING: bad click!\n");
       }
-      case 2: // levelup
-        if (!game_levelup(game, handler)) {
-          fprintf(stderr, "WARNING: bad levelup!\n");
-        }
-        break;
-      case 3: // give up
-        return iter;
-      default:
-        fprintf(stderr, "WARNING: bad hint: %08x\n", hint);
-        return iter;
+      return true;
+    case 1: // note
+      game_hover(game, handler, x, y);
+      game_note(game, handler, note);
+      return true;
+    case 2: // levelup
+      if (!game_levelup(game, handler)) {
+        fprintf(stderr, "WARNING: bad levelup!\n");
+      }
+      return true;
+    case 3: // give up
+      return false;
+  }
+  fprintf(stderr, "WARNING: bad hint: %08x\n", hint);
+  return false;
+}
+
+i32 play_game(struct game_st *game, i32 diff, u32 seed, const u8 *board, i32 knowledge) {
+  // new games on the GBA use the single pass shuffle, so test against that
+  game_new(game, diff | D_VERSION1, seed, board);
+  return play_from(game, knowledge, &hint_weights_default);
+}
+
+i32 play_turn(struct game_st *game, i32 knowledge, const struct hint_weights_st *weights) {
+  // play all the risk-free moves before asking for the next decision
+  u32 forced[BOARD_SIZE];
+  i32 count = game_forced(game, forced, BOARD_SIZE);
+  i32 played = 0;
+  for (i32 i = 0; i < count; i++) {
+    if (game_forced_valid(game, forced[i])) {
+      played++;
+      play_hint(game, forced[i]);
     }
   }
+  if (played > 0) return played;
+  return play_hint(game, game_hint_weighted(game, handler, knowledge, weights)) ? 0 : -1;
+}
+
+i32 play_from(struct game_st *game, i32 knowledge, const struct hint_weights_st *weights) {
+  i32 iter = 0;
+  while (game->win == 0) {
+    i32 played = play_turn(game, knowledge, weights);
+    iter += played > 0 ? played : 1;
+    if (played < 0) break;
+  }
   return iter;
 }
 
-static bool acceptable_easy(const u8 *board) {
-  struct game_st game;
-  // play with no special knowledge
-  play_game(&game, 0, 1, board, 0);
-  // accept if you win!
-  return game.win == 2;
+// how a game on the candidate board ended, with one knowledge mask
+struct outcome_st {
+  i32 knowledge;
+  u8 win;
+  u8 level;
+  u8 stopped; // stopped once it reached level, instead of playing out
+};
+
+// the games played so far on a candidate board; the difficulty only matters to game_new through
+// D_ONLYMINES, so every test that plays a mask on the board can share one game of it
+struct candidate_st {
+  const u8 *board;
+  struct generate_stats_st *stats;
+  i32 count;
+  struct outcome_st outcomes[6]; // at most one per mask the tests use
+};
+
+// where stats counts a knowledge mask
+static i32 mask_index(i32 knowledge) {
+  switch (knowledge) {
+    case 0: return 0;
+    case 1: return 1;
+    case 7: return 2;
+    case 31: return 3;
+    case 63: return 4;
+  }
+  return 5;
+}
+
+// the outcome of the mask's game, if it was played far enough to tell whether it reaches `upto`
+// (or played out, for 0)
+static struct outcome_st *candidate_find(struct candidate_st *cand, i32 knowledge, i32 upto) {
+  for (i32 i = 0; i < cand->count; i++) {
+    struct outcome_st *out = &cand->outcomes[i];
+    if (out->knowledge != knowledge) continue;
+    return !out->stopped || (upto > 0 && upto <= out->level) ? out : NULL;
+  }
+  return NULL;
 }
 
-static bool acceptable_mild(const u8 *board) {
+// play the mask until it reaches upto (0 = play out), unless an earlier game already tells
+static void candidate_run(struct candidate_st *cand, i32 knowledge, i32 upto) {
+  if (candidate_find(cand, knowledge, upto)) return;
   struct game_st game;
-  // play trying to save lv1+2
-  play_game(&game, 1, 1, board, 1);
-  // accept if you got far
-  return game.level >= 12;
+  // same as play_game
+  game_new(&game, 0 | D_VERSION1, 1, cand->board);
+  i32 moves = 0;
+  bool stopped = false;
+  while (game.win == 0) {
+    if (upto && game.level >= upto) {
+      stopped = true;
+      break;
+    }
+    i32 played = play_turn(&game, knowledge, &hint_weights_default);
+    moves += played > 0 ? played : 1;
+    if (played < 0) break;
+  }
+  // a game that didn't go far enough is replaced, since playing it further replays the start
+  struct outcome_st *out = &cand->outcomes[cand->count];
+  for (i32 i = 0; i < cand->count; i++) {
+    if (cand->outcomes[i].knowledge == knowledge) out = &cand->outcomes[i];
+  }
+  if (out == &cand->outcomes[cand->count]) cand->count++;
+  out->knowledge = knowledge;
+  out->win = game.win;
+  out->level = game.level;
+  out->stopped = stopped;
+  if (cand->stats) {
+    i32 m = mask_index(knowledge);
+    cand->stats->games[m]++;
+    cand->stats->moves[m] += moves;
+  }
+}
+
+static const struct outcome_st *candidate_game(struct candidate_st *cand, i32 knowledge, i32 upto) {
+  candidate_run(cand, knowledge, upto);
+  return candidate_find(cand, knowledge, upto);
+}
+
+// each test stops its games as soon as the level they reach decides it
+
+static bool acceptable_easy(struct candidate_st *cand) {
+  // accept if you win with no special knowledge
+  return candidate_game(cand, 0, 0)->win == 2;
 }
 
-static bool acceptable_normal(const u8 *board) {
-  struct game_st game1;
-  struct game_st game2;
-  // play one version with no knowledge
-  play_game(&game1, 2, 1, board, 0);
-  // play another with some basic strategy
-  play_game(&game2, 2, 1, board, 31);
+static bool acceptable_mild(struct candidate_st *cand) {
+  // accept if you got far trying to save lv1+2
+  return candidate_game(cand, 1, 12)->level >= 12;
+}
+
+static bool acceptable_normal(struct candidate_st *cand) {
+  // play one version with no knowledge, and another with some basic strategy
+  candidate_run(cand, 0, 10);
+  candidate_run(cand, 31, 15);
   // accept if your basic strategy was decisive
-  return game1.level <= 9 && game2.level >= 15;
+  return candidate_find(cand, 0, 10)->level <= 9 && candidate_find(cand, 31, 15)->level >= 15;
 }
 
-static bool acceptable_hard(const u8 *board) {
-  struct game_st game1;
-  struct game_st game2;
-  // play one version with simple knowledge
-  play_game(&game1, 3, 1, board, 7);
-  // play another with some moderate strategy
-  play_game(&game2, 3, 1, board, 63);
+static bool acceptable_hard(struct candidate_st *cand) {
+  // play one version with simple knowledge, and another with some moderate strategy
+  candidate_run(cand, 7, 9);
+  candidate_run(cand, 63, 13);
   // accept if your moderate strategy helped to nearly win
-  return game1.level <= 8 && game2.level >= 13;
+  return candidate_find(cand, 7, 9)->level <= 8 && candidate_find(cand, 63, 13)->level >= 13;
 }
 
-static bool acceptable_expert(const u8 *board) {
-  struct game_st game1;
-  struct game_st game2;
-  // play one version with simple knowledge
-  play_game(&game1, 4, 1, board, 7);
-  // play another with max strategy
-  play_game(&game2, 4, 1, board, -1);
+static bool acceptable_expert(struct candidate_st *cand) {
+  // play one version with simple knowledge, and another with max strategy
+  candidate_run(cand, 7, 6);
+  candidate_run(cand, -1, 10);
   // accept if your max strategy helped get to late game
-  return game1.level <= 5 && game2.level >= 10;
+  return candidate_find(cand, 7, 6)->level <= 5 && candidate_find(cand, -1, 10)->level >= 10;
 }
 
-static bool acceptable_difficulty(const u8 *board, i32 diff) {
+static bool acceptable_difficulty(const u8 *board, i32 diff, struct generate_stats_st *stats) {
+  struct candidate_st cand = { board, stats, 0 };
+  // the test a board has to pass goes first, since it rejects the most; its games that have to
+  // stay under a level also play out when it passes, so the tests after it can reuse them
   switch (diff) {
     case 0:
-      return acceptable_easy(board);
+      return acceptable_easy(&cand);
     case 1:
       return
-        !acceptable_easy(board) &&
-        acceptable_mild(board);
+        acceptable_mild(&cand) &&
+        !acceptable_easy(&cand);
     case 2:
       return
-        !acceptable_easy(board) &&
-        !acceptable_mild(board) &&
-        acceptable_normal(board);
+        acceptable_normal(&cand) &&
+        !acceptable_mild(&cand) &&
+        !acceptable_easy(&cand);
     case 3:
       return
-        !acceptable_easy(board) &&
-        !acceptable_mild(board) &&
-        !acceptable_normal(board) &&
-        acceptable_hard(board);
+        acceptable_hard(&cand) &&
+        !acceptable_mild(&cand) &&
+        !acceptable_easy(&cand) &&
+        !acceptable_normal(&cand);
     case 4:
       return
-        !acceptable_easy(board) &&
-        !acceptable_mild(board) &&
-        !acceptable_normal(board) &&
-        !acceptable_hard(board) &&
-        acceptable_expert(board);
+        acceptable_expert(&cand) &&
+        !acceptable_hard(&cand) &&
+        !acceptable_mild(&cand) &&
+        !acceptable_easy(&cand) &&
+        !acceptable_normal(&cand);
   }
   return false;
 }
 
-void generate_levels(u8 *levels, i32 count, struct rnd_st *rnd) {
-  i32 fails[5] = {0};
-  for (i32 group = 0; group < count; group++) {
-    if ((group % 10) == 9 || group == count - 1) {
-      printf("generating levels %4d/%d; fails per difficulty:%3d,%3d,%3d,%4d,%3d\n",
-        group + 1, count,
-        fails[0], fails[1], fails[2], fails[3], fails[4]
-      );
-      for (i32 i = 0; i < 5; i++) fails[i] = 0;
+static u64 now_ns() {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (u64)t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+i32 generate_board(u8 *board, i32 diff, struct rnd_st *rnd, struct generate_stats_st *stats) {
+  i32 fails = 0;
+  for (;;) {
+    u64 t0 = stats ? now_ns() : 0;
+    generate_full(board, diff, rnd, stats);
+    u64 t1 = stats ? now_ns() : 0;
+    bool ok = acceptable_difficulty(board, diff, stats);
+    if (stats) {
+      stats->generate_ns += t1 - t0;
+      stats->simulate_ns += now_ns() - t1;
+      stats->candidates[diff]++;
+      stats->accepted[diff] += ok;
     }
-    i32 gk = 128 * 6 * group;
-    for (i32 diff = 0; diff < 5; diff++) {
-      u8 *board = &levels[gk + 128 * diff];
-      for (;;) {
-        generate_full(board, diff, rnd);
-        if (acceptable_difficulty(board, diff)) break;
-        fails[diff]++;
-      }
-      if (group < 2) {
-        // print some example games
-        printf("group %d difficulty %d\n", group, diff);
-        print_board(&levels[gk + 128 * diff]);
+    if (ok) return fails;
+    fails++;
+  }
+}
+
+struct levels_job_st {
+  u8 *levels;
+  u32 seed;
+  i32 count;
+  i32 done;
+  i32 fails[5];
+  struct generate_stats_st *stats;
+};
+
+// job 6 * group + slot makes the board for difficulty `slot`, or the only mines boards for slot 5,
+// each from its own stream so the result doesn't depend on what order the jobs run in
+static void levels_job(i32 index, void *user) {
+  struct levels_job_st *job = user;
+  i32 group = index / 6;
+  i32 slot = index % 6;
+  struct rnd_st rnd;
+  rnd_seed(&rnd, whisky2(whisky2(job->seed, group), slot));
+  u8 *levels = job->levels + GROUP_STRIDE * group;
+  if (slot < 5) {
+    struct generate_stats_st stats = {0};
+    u8 *board = levels + LEVEL_STRIDE * slot;
+    i32 fails = generate_board(board, slot, &rnd, job->stats ? &stats : NULL);
+    __atomic_add_fetch(&job->fails[slot], fails, __ATOMIC_RELAXED);
+    if (job->stats) {
+      // every field is a u64, so add them up as an array
+      const u64 *from = (const u64 *)&stats;
+      u64 *to = (u64 *)job->stats;
+      for (size_t i = 0; i < sizeof(stats) / sizeof(u64); i++) {
+        if (from[i]) __atomic_add_fetch(&to[i], from[i], __ATOMIC_RELAXED);
       }
     }
+  } else {
     for (int diff = 0; diff < 5; diff++) {
       u8 board[BOARD_SIZE];
-      generate_onlymines(board, diff, rnd);
+      generate_onlymines(board, diff, &rnd);
       // embed mine games as bits on the 6th board for each difficulty
       for (int i = 0; i < BOARD_SIZE; i++) {
-        levels[gk + 128 * 5 + i] |= board[i] ? (1 << diff) : 0;
+        levels[LEVEL_STRIDE * 5 + i] |= board[i] ? (1 << diff) : 0;
       }
     }
   }
+  i32 done = __atomic_add_fetch(&job->done, 1, __ATOMIC_RELAXED);
+  if ((done % 60) == 0 || done == job->count * 6) {
+    printf("\x1b[Agenerating levels %4d/%d; fails per difficulty:%6d,%6d,%6d,%7d,%6d\n",
+      done / 6, job->count,
+      __atomic_load_n(&job->fails[0], __ATOMIC_RELAXED),
+      __atomic_load_n(&job->fails[1], __ATOMIC_RELAXED),
+      __atomic_load_n(&job->fails[2], __ATOMIC_RELAXED),
+      __atomic_load_n(&job->fails[3], __ATOMIC_RELAXED),
+      __atomic_load_n(&job->fails[4], __ATOMIC_RELAXED)
+    );
+    fflush(stdout);
+  }
+}
+
+void generate_levels(
+  u8 *levels,
+  i32 count,
+  u32 seed,
+  i32 threads,
+  struct generate_stats_st *stats
+) {
+  struct levels_job_st job = { levels, seed, count, 0, {0}, stats };
+  if (stats) *stats = (struct generate_stats_st){0};
+  printf("\n");
+  u64 start = now_ns();
+  pool_run(count * 6, threads, levels_job, &job);
+  if (stats) {
+    stats->wall_ns = now_ns() - start;
+    stats->threads = threads > 0 ? threads : pool_cores();
+  }
+  // print some example games
+  for (i32 group = 0; group < 2 && group < count; group++) {
+    for (i32 diff = 0; diff < 5; diff++) {
+      printf("group %d difficulty %d\n", group, diff);
+      print_board(&levels[GROUP_STRIDE * group + LEVEL_STRIDE * diff]);
+    }
+  }
+}
+
+void generate_stats_json(FILE *fp, const struct generate_stats_st *stats) {
+  static const char *stages[GS__SIZE] = {
+    "lv7", "lv4", "mines", "nostart_mines", "chests", "nostart_chests", "start"
+  };
+  static const char *masks[GENERATE_MASKS] = { "0", "1", "7", "31", "63", "-1" };
+  #define U(v)  ((unsigned long long)(v))
+  fprintf(fp, "{\n  \"restarts\": {");
+  for (i32 i = 0; i < GS__SIZE; i++) {
+    fprintf(fp, "%s\"%s\": %llu", i ? ", " : "", stages[i], U(stats->restarts[i]));
+  }
+  fprintf(fp, "},\n  \"difficulties\": [");
+  for (i32 i = 0; i < 5; i++) {
+    fprintf(
+      fp,
+      "%s{\"candidates\": %llu, \"accepted\": %llu}",
+      i ? ", " : "", U(stats->candidates[i]), U(stats->accepted[i])
+    );
+  }
+  fprintf(fp, "],\n  \"knowledge\": {");
+  for (i32 i = 0; i < GENERATE_MASKS; i++) {
+    fprintf(
+      fp,
+      "%s\"%s\": {\"games\": %llu, \"moves\": %llu}",
+      i ? ", " : "", masks[i], U(stats->games[i]), U(stats->moves[i])
+    );
+  }
+  fprintf(
+    fp,
+    "},\n  \"seconds\": {\"generate\": %.3f, \"simulate\": %.3f, \"wall\": %.3f},\n"
+    "  \"threads\": %llu\n}\n",
+    stats->generate_ns / 1e9, stats->simulate_ns / 1e9, stats->wall_ns / 1e9, U(stats->threads)
+  );
+  #undef U
 }
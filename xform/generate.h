@@ -6,6 +6,7 @@
 //
 
 #include <stdint.h>
+#include <stdio.h>
 #include "../src/game.h"
 
 typedef uint8_t  u8;
@@ -15,4 +16,56 @@ typedef int8_t   i8;
 typedef int16_t  i16;
 typedef int32_t  i32;
 
-void generate_levels(u8 *levels, i32 count, struct rnd_st *rnd);
+// where generate_full gave up on a board and started over
+enum generate_stage {
+  GS_LV7,             // no room for the lv7 box
+  GS_LV4,             // no room for a pair of lv4's
+  GS_MINES,           // no room for a mine
+  GS_NOSTART_MINES,   // nowhere to start once the mines were placed
+  GS_CHESTS,          // no room for a chest
+  GS_NOSTART_CHESTS,  // nowhere to start once the chests were placed
+  GS_START,           // the last pieces kept covering every start
+  GS__SIZE
+};
+
+// knowledge masks the acceptance tests play, in the order generate_stats_st counts them
+#define GENERATE_MASKS  6
+
+// what generating levels spent its time on, see generate_stats_json; every field is a u64 counter
+struct generate_stats_st {
+  u64 restarts[GS__SIZE];          // generate_full restarts, by the stage that gave up
+  u64 candidates[5];               // boards generate_full made, per difficulty
+  u64 accepted[5];                 // boards that passed the tests, per difficulty
+  u64 games[GENERATE_MASKS];       // games played by the tests, per knowledge mask
+  u64 moves[GENERATE_MASKS];       // moves played in them
+  u64 generate_ns;                 // time in generate_full, summed over threads
+  u64 simulate_ns;                 // time in the tests, summed over threads
+  u64 wall_ns;                     // time generate_levels took
+  u64 threads;
+};
+
+// play a normal game to the end with game_hint, taking forced moves as they come up; returns the
+// number of moves played
+i32 play_game(struct game_st *game, i32 diff, u32 seed, const u8 *board, i32 knowledge);
+// same as play_game, but continues a game that's already set up
+i32 play_from(struct game_st *game, i32 knowledge, const struct hint_weights_st *weights);
+// one step of play_from: every forced move if there are any, otherwise a hint; returns how many
+// forced moves were played, 0 for a hint, or -1 if the hint gave up
+i32 play_turn(struct game_st *game, i32 knowledge, const struct hint_weights_st *weights);
+// place every piece for a board of difficulty diff, without checking how it plays; stats can be
+// NULL
+void generate_full(u8 *board, i32 diff, struct rnd_st *rnd, struct generate_stats_st *stats);
+// generate a board that passes the acceptance tests for diff; returns the number of rejects
+i32 generate_board(u8 *board, i32 diff, struct rnd_st *rnd, struct generate_stats_st *stats);
+// fill count groups of levels (GROUP_STRIDE bytes each, zeroed) across `threads` threads (0 = one
+// per core); every board has its own random stream from seed, so any thread count gives the same
+// levels, and fill in stats (which can be NULL)
+void generate_levels(
+  u8 *levels,
+  i32 count,
+  u32 seed,
+  i32 threads,
+  struct generate_stats_st *stats
+);
+// write stats out as a JSON object
+void generate_stats_json(FILE *fp, const struct generate_stats_st *stats);
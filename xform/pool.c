@@ -0,0 +1,137 @@
+//
+// cryptsweeper - fight the graveyard monsters and stop death
+// by Pocket Pulp (@velipso), https://pulp.biz
+// Project Home: https://github.com/velipso/cryptsweeper
+// SPDX-License-Identifier: 0BSD
+//
+
+//
+// Work stealing over index ranges: each thread starts with an even slice of [0, count) and takes
+// jobs off the front of it, and when it runs dry, it steals the back half of the fullest slice
+// left. Slices are a packed (begin, end) pair, so taking and stealing are both one CAS.
+//
+
+#include "pool.h"
+#include <stdbool.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#define POOL_MAX  256
+
+struct slice_st {
+  uint64_t range; // begin in the low 32 bits, end in the high 32 bits
+  char pad[56];   // keep each slice on its own cache line
+};
+
+struct pool_st {
+  i32 threads;
+  pool_job_f job;
+  void *user;
+  struct slice_st slices[POOL_MAX];
+};
+
+struct worker_st {
+  struct pool_st *pool;
+  i32 id;
+};
+
+#define RANGE(b, e)     (((uint64_t)(uint32_t)(e) << 32) | (uint32_t)(b))
+#define RANGE_BEGIN(r)  ((i32)(uint32_t)(r))
+#define RANGE_END(r)    ((i32)((r) >> 32))
+
+i32 pool_cores() {
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return n < 1 ? 1 : n;
+}
+
+// take the next job off the front of our own slice
+static i32 pool_take(struct slice_st *slice) {
+  uint64_t r = __atomic_load_n(&slice->range, __ATOMIC_ACQUIRE);
+  for (;;) {
+    i32 b = RANGE_BEGIN(r);
+    i32 e = RANGE_END(r);
+    if (b >= e) return -1;
+    if (__atomic_compare_exchange_n(
+      &slice->range, &r, RANGE(b + 1, e), false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE
+    )) {
+      return b;
+    }
+  }
+}
+
+// move the back half of the fullest other slice into ours, and return false if all are empty
+static bool pool_steal(struct pool_st *pool, i32 id) {
+  for (;;) {
+    i32 victim = -1;
+    i32 most = 0;
+    for (i32 i = 0; i < pool->threads; i++) {
+      uint64_t r = __atomic_load_n(&pool->slices[i].range, __ATOMIC_ACQUIRE);
+      i32 left = RANGE_END(r) - RANGE_BEGIN(r);
+      if (i != id && left > most) {
+        most = left;
+        victim = i;
+      }
+    }
+    if (victim < 0) return false;
+    struct slice_st *slice = &pool->slices[victim];
+    uint64_t r = __atomic_load_n(&slice->range, __ATOMIC_ACQUIRE);
+    i32 b = RANGE_BEGIN(r);
+    i32 e = RANGE_END(r);
+    if (b >= e) continue;
+    i32 mid = e - (e - b + 1) / 2;
+    if (__atomic_compare_exchange_n(
+      &slice->range, &r, RANGE(b, mid), false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE
+    )) {
+      // only we write our own slice while it's empty, so a plain store is enough
+      __atomic_store_n(&pool->slices[id].range, RANGE(mid, e), __ATOMIC_RELEASE);
+      return true;
+    }
+  }
+}
+
+static void *pool_worker(void *arg) {
+  struct worker_st *worker = arg;
+  struct pool_st *pool = worker->pool;
+  struct slice_st *own = &pool->slices[worker->id];
+  for (;;) {
+    i32 index = pool_take(own);
+    if (index < 0) {
+      if (!pool_steal(pool, worker->id)) break;
+      continue;
+    }
+    pool->job(index, pool->user);
+  }
+  return NULL;
+}
+
+void pool_run(i32 count, i32 threads, pool_job_f job, void *user) {
+  if (count <= 0) return;
+  if (threads <= 0) threads = pool_cores();
+  if (threads > count) threads = count;
+  if (threads > POOL_MAX) threads = POOL_MAX;
+  struct pool_st pool;
+  pool.threads = threads;
+  pool.job = job;
+  pool.user = user;
+  for (i32 i = 0; i < threads; i++) {
+    pool.slices[i].range = RANGE(
+      (int64_t)count * i / threads,
+      (int64_t)count * (i + 1) / threads
+    );
+  }
+  struct worker_st workers[threads];
+  pthread_t tid[threads];
+  i32 started = 0;
+  for (i32 i = 0; i < threads; i++) {
+    workers[i].pool = &pool;
+    workers[i].id = i;
+  }
+  for (i32 i = 1; i < threads; i++, started++) {
+    if (pthread_create(&tid[i], NULL, pool_worker, &workers[i]) != 0) break;
+  }
+  // this thread works too, and steals whatever slices didn't get a thread
+  pool_worker(&workers[0]);
+  for (i32 i = 1; i <= started; i++) {
+    pthread_join(tid[i], NULL);
+  }
+}
@@ -0,0 +1,17 @@
+//
+// cryptsweeper - fight the graveyard monsters and stop death
+// by Pocket Pulp (@velipso), https://pulp.biz
+// Project Home: https://github.com/velipso/cryptsweeper
+// SPDX-License-Identifier: 0BSD
+//
+
+#include <stdint.h>
+
+typedef int32_t  i32;
+
+typedef void (*pool_job_f)(i32 index, void *user);
+
+i32 pool_cores();
+// calls job(index, user) for every index in [0, count) spread across `threads` threads (0 = one per
+// core), and returns when they're all done
+void pool_run(i32 count, i32 threads, pool_job_f job, void *user);
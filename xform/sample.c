@@ -0,0 +1,442 @@
+//
+// cryptsweeper - fight the graveyard monsters and stop death
+// by Pocket Pulp (@velipso), https://pulp.biz
+// Project Home: https://github.com/velipso/cryptsweeper
+// SPDX-License-Identifier: 0BSD
+//
+
+//
+// Monte Carlo sampler for what could be hidden on a board.
+//
+// Each chain starts from the real board and proposes swapping two random hidden cells. A swap is
+// kept if it doesn't change anything the player can see, and doesn't break a placement rule, so
+// the chain wanders uniformly over the boards that fit what the player knows. Consecutive samples
+// share everything but the swapped pair, so instead of tallying every cell on every step, each
+// cell only adds up how long it held a tile when that tile leaves.
+//
+
+#include "sample.h"
+#include "pool.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+void sample_help() {
+  printf(
+    "  sample <levels.bin> <group> <difficulty> <moves> <samples> [threads]\n"
+    "    Play some moves with game_hint, then sample what could be hidden\n"
+  );
+}
+
+#define BURN_IN  20000 // steps per chain before sampling, to forget the real board
+#define CHAINS   8     // chains sample_main splits its samples over, whatever the thread count
+
+static inline bool shows_threat(u8 b) {
+  return GET_STATUS(b) >= S_PRESSED && IS_EMPTY(b);
+}
+
+static inline bool adjacent(i32 a, i32 b) {
+  i32 dx = a % BOARD_W - b % BOARD_W;
+  i32 dy = a / BOARD_W - b / BOARD_W;
+  return a != b && dx >= -1 && dx <= 1 && dy >= -1 && dy <= 1;
+}
+
+// tiles that generate_full places by rule instead of randomly
+static inline bool rule_tile(i32 t) {
+  switch (t) {
+    case T_LV1B:
+    case T_LV4A:
+    case T_LV4B:
+    case T_LV4C:
+    case T_LV6:
+    case T_LV7:
+    case T_LV8:
+    case T_LV9:
+    case T_LV10:
+    case T_MINE:
+    case T_WALL:
+    case T_CHEST_HEAL:
+    case T_CHEST_EYE2:
+    case T_CHEST_EXP:
+      return true;
+  }
+  return false;
+}
+
+static inline i32 type_at(const u8 *board, i32 x, i32 y) {
+  if (x < 0 || x >= BOARD_W || y < 0 || y >= BOARD_H) return -1;
+  return GET_TYPEXY(board, x, y);
+}
+
+// count how many tiles are out of place according to generate_full
+static i32 violations(const u8 *board) {
+  i32 result = 0;
+  for (i32 y = 0; y < BOARD_H; y++) {
+    for (i32 x = 0; x < BOARD_W; x++) {
+      i32 t = GET_TYPEXY(board, x, y);
+      // no cell is threatened by more than four mines
+      i32 mines = 0;
+      for (i32 dy = -1; dy <= 1; dy++) {
+        for (i32 dx = -1; dx <= 1; dx++) {
+          if ((dx || dy) && type_at(board, x + dx, y + dy) == T_MINE) mines++;
+        }
+      }
+      if (mines > 4) result++;
+      switch (t) {
+        case T_LV10: // in a corner
+          if ((x != 0 && x != BOARD_W - 1) || (y != 0 && y != BOARD_H - 1)) result++;
+          break;
+        case T_LV9: // mirrored
+          if (type_at(board, BOARD_W - 1 - x, y) != T_LV9) result++;
+          break;
+        case T_LV1B: // on the edge, surrounded by lv8's
+          if (x != 0 && x != BOARD_W - 1 && y != 0 && y != BOARD_H - 1) result++;
+          for (i32 dy = -1; dy <= 1; dy++) {
+            for (i32 dx = -1; dx <= 1; dx++) {
+              i32 n = type_at(board, x + dx, y + dy);
+              if ((dx || dy) && n >= 0 && n != T_LV8) result++;
+            }
+          }
+          break;
+        case T_LV8: { // next to the lv1b
+          bool found = false;
+          for (i32 dy = -1; dy <= 1; dy++) {
+            for (i32 dx = -1; dx <= 1; dx++) {
+              if (type_at(board, x + dx, y + dy) == T_LV1B) found = true;
+            }
+          }
+          if (!found) result++;
+          break;
+        }
+        case T_LV7: { // corner of a box
+          bool found = false;
+          for (i32 x2 = 0; x2 < BOARD_W && !found; x2++) {
+            if (x2 == x || GET_TYPEXY(board, x2, y) != T_LV7) continue;
+            for (i32 y2 = 0; y2 < BOARD_H && !found; y2++) {
+              found =
+                y2 != y &&
+                GET_TYPEXY(board, x, y2) == T_LV7 &&
+                GET_TYPEXY(board, x2, y2) == T_LV7;
+            }
+          }
+          if (!found) result++;
+          break;
+        }
+        case T_WALL: // in pairs
+        case T_LV4A: // rooks
+          if (
+            type_at(board, x - 1, y) != t &&
+            type_at(board, x + 1, y) != t &&
+            type_at(board, x, y - 1) != t &&
+            type_at(board, x, y + 1) != t
+          ) {
+            result++;
+          }
+          break;
+        case T_LV4B: // bishops
+          if (
+            type_at(board, x - 1, y - 1) != t &&
+            type_at(board, x + 1, y - 1) != t &&
+            type_at(board, x - 1, y + 1) != t &&
+            type_at(board, x + 1, y + 1) != t
+          ) {
+            result++;
+          }
+          break;
+        case T_LV4C: { // knights
+          static const i8 jumps[8][2] = {
+            {-2, -1}, {-2, 1}, {-1, -2}, {-1, 2}, {1, -2}, {1, 2}, {2, -1}, {2, 1}
+          };
+          bool found = false;
+          for (i32 i = 0; i < 8; i++) {
+            if (type_at(board, x + jumps[i][0], y + jumps[i][1]) == t) found = true;
+          }
+          if (!found) result++;
+          break;
+        }
+        case T_LV6: { // next to a chest
+          bool found = false;
+          for (i32 dy = -1; dy <= 1; dy++) {
+            for (i32 dx = -1; dx <= 1; dx++) {
+              i32 n = type_at(board, x + dx, y + dy);
+              if (n >= 0 && IS_CHEST(n)) found = true;
+            }
+          }
+          if (!found) result++;
+          break;
+        }
+      }
+    }
+  }
+  return result;
+}
+
+bool sample_swap_ok(const struct game_st *game, i32 a, i32 b) {
+  i32 ta = GET_TYPE(game->board[a]);
+  i32 tb = GET_TYPE(game->board[b]);
+  if (ta == tb) return true;
+  if (ta == T_LV5C || tb == T_LV5C) return false; // would move the witch's mask
+
+  // threat numbers around either cell
+  i32 delta = game_tiles[tb].threat - game_tiles[ta].threat;
+  for (i32 i = 0; i < 2 && delta; i++) {
+    i32 c = i == 0 ? a : b;
+    i32 cx = c % BOARD_W;
+    i32 cy = c / BOARD_W;
+    for (i32 y = cy - 1; y <= cy + 1; y++) {
+      if (y < 0 || y >= BOARD_H) continue;
+      for (i32 x = cx - 1; x <= cx + 1; x++) {
+        if (x < 0 || x >= BOARD_W) continue;
+        i32 r = x + y * BOARD_W;
+        if (!shows_threat(game->board[r])) continue;
+        if (i == 1 && adjacent(r, a)) continue; // already checked
+        i32 d = (adjacent(r, a) ? delta : 0) - (adjacent(r, b) ? delta : 0);
+        if (d == 0) continue;
+        i32 t = game->threat[r];
+        if (!PLANE_GET(game->witched, x, y) || ((t + d) | 0xff) != (t | 0xff)) {
+          return false;
+        }
+      }
+    }
+  }
+
+  // placement rules, where anything already broken (like a killed lv8) stays that way
+  if (rule_tile(ta) || rule_tile(tb)) {
+    u8 board[BOARD_SIZE];
+    memcpy(board, game->board, BOARD_SIZE);
+    i32 before = violations(board);
+    board[a] = game->board[b];
+    board[b] = game->board[a];
+    if (violations(board) > before) return false;
+  }
+  return true;
+}
+
+void sample_shuffle(struct game_st *game, struct rnd_st *rnd, i32 steps) {
+  i16 hidden[BOARD_SIZE];
+  i32 hidden_size = 0;
+  for (i32 k = 0; k < BOARD_SIZE; k++) {
+    if (GET_STATUS(game->board[k]) == S_HIDDEN) {
+      hidden[hidden_size++] = k;
+    }
+  }
+  for (i32 step = 0; step < steps && hidden_size >= 2; step++) {
+    i32 a = hidden[roll(rnd, hidden_size)];
+    i32 b = hidden[roll(rnd, hidden_size)];
+    if (GET_TYPE(game->board[a]) != GET_TYPE(game->board[b]) && sample_swap_ok(game, a, b)) {
+      game_swap(game, a, b);
+    }
+  }
+}
+
+struct chain_st {
+  const struct game_st *game;
+  u64 steps;
+  u32 seed;
+  u64 *held;     // steps each cell held each type, over every chain
+  u64 accepted;
+};
+
+static void run_chain(i32 index, void *user) {
+  struct chain_st *chain = user;
+  struct rnd_st rnd;
+  rnd_seed(&rnd, whisky2(chain->seed, index));
+  struct game_st game = *chain->game;
+  i16 hidden[BOARD_SIZE];
+  i32 hidden_size = 0;
+  for (i32 k = 0; k < BOARD_SIZE; k++) {
+    if (GET_STATUS(game.board[k]) == S_HIDDEN) {
+      hidden[hidden_size++] = k;
+    }
+  }
+
+  u64 accepted = 0;
+  u64 *held = calloc(BOARD_SIZE * T__SIZE, sizeof(u64));
+  u64 since[BOARD_SIZE];
+  for (u64 step = 0; step < BURN_IN + chain->steps && hidden_size >= 2; step++) {
+    if (step == BURN_IN) {
+      for (i32 i = 0; i < hidden_size; i++) since[hidden[i]] = 0;
+      accepted = 0;
+    }
+    i32 a = hidden[roll(&rnd, hidden_size)];
+    i32 b = hidden[roll(&rnd, hidden_size)];
+    if (GET_TYPE(game.board[a]) == GET_TYPE(game.board[b]) || !sample_swap_ok(&game, a, b)) {
+      continue;
+    }
+    if (step >= BURN_IN) {
+      u64 now = step - BURN_IN;
+      held[a * T__SIZE + GET_TYPE(game.board[a])] += now - since[a];
+      held[b * T__SIZE + GET_TYPE(game.board[b])] += now - since[b];
+      since[a] = since[b] = now;
+    }
+    game_swap(&game, a, b);
+    accepted++;
+  }
+  if (hidden_size < 2) {
+    for (i32 i = 0; i < hidden_size; i++) since[hidden[i]] = 0;
+  }
+  for (i32 i = 0; i < hidden_size; i++) {
+    i32 k = hidden[i];
+    held[k * T__SIZE + GET_TYPE(game.board[k])] += chain->steps - since[k];
+  }
+
+  // integer adds, so the totals don't depend on which chain finishes first
+  for (i32 i = 0; i < BOARD_SIZE * T__SIZE; i++) {
+    if (held[i]) {
+      __atomic_add_fetch(&chain->held[i], held[i], __ATOMIC_RELAXED);
+    }
+  }
+  __atomic_add_fetch(&chain->accepted, accepted, __ATOMIC_RELAXED);
+  free(held);
+}
+
+void sample_board(
+  const struct game_st *game,
+  u64 samples,
+  i32 chains,
+  i32 threads,
+  u32 seed,
+  struct sample_st *out
+) {
+  if (chains < 1) chains = 1;
+  struct chain_st chain;
+  chain.game = game;
+  chain.steps = (samples + chains - 1) / chains;
+  chain.seed = seed;
+  chain.held = calloc(BOARD_SIZE * T__SIZE, sizeof(u64));
+  chain.accepted = 0;
+  pool_run(chains, threads, run_chain, &chain);
+
+  out->samples = chain.steps * chains;
+  out->accepted = chain.accepted;
+  for (i32 k = 0; k < BOARD_SIZE; k++) {
+    for (i32 t = 0; t < T__SIZE; t++) {
+      out->prob[k][t] = GET_STATUS(game->board[k]) == S_HIDDEN
+        ? (float)((double)chain.held[k * T__SIZE + t] / out->samples)
+        : GET_TYPE(game->board[k]) == t;
+    }
+  }
+  free(chain.held);
+}
+
+static void handler(struct game_st *game, enum game_event ev, i32 x, i32 y) {
+  // do nothing
+}
+
+static void play_hint(struct game_st *game, u32 hint) {
+  switch ((hint >> 16) & 0xff) {
+    case 0: // click
+    case 1: // note
+      game_hover(game, handler, hint & 0xff, (hint >> 8) & 0xff);
+      if ((hint >> 16) & 0xff) {
+        game_note(game, handler, (i8)(hint >> 24));
+      } else {
+        game_click(game, handler);
+      }
+      break;
+    case 2: // levelup
+      game_levelup(game, handler);
+      break;
+  }
+}
+
+int sample_main(int argc, const char **argv) {
+  if (argc < 5 || argc > 6) {
+    sample_help();
+    fprintf(stderr, "\nExpecting: sample <levels.bin> <group> <difficulty> <moves> <samples> [threads]\n");
+    return 1;
+  }
+  i32 group = atoi(argv[1]);
+  i32 diff = atoi(argv[2]);
+  i32 moves = atoi(argv[3]);
+  u64 samples = strtoull(argv[4], NULL, 10);
+  i32 threads = argc >= 6 ? atoi(argv[5]) : 0;
+  if (diff < 0 || diff > 4) {
+    fprintf(stderr, "\nBad difficulty: %d\n", diff);
+    return 1;
+  }
+
+  FILE *fp = fopen(argv[0], "rb");
+  if (fp == NULL) {
+    fprintf(stderr, "\nFailed to read: %s\n", argv[0]);
+    return 1;
+  }
+  u8 board[LEVEL_STRIDE];
+  if (
+    group < 0 ||
+    fseek(fp, group * GROUP_STRIDE + diff * LEVEL_STRIDE, SEEK_SET) != 0 ||
+    fread(board, LEVEL_STRIDE, 1, fp) != 1
+  ) {
+    fclose(fp);
+    fprintf(stderr, "\nBad group: %d\n", group);
+    return 1;
+  }
+  fclose(fp);
+
+  // get to a position worth asking about
+  struct game_st game;
+  game_new(&game, diff | D_VERSION1, 1, board);
+  u32 forced[BOARD_SIZE];
+  for (i32 move = 0; move < moves && !game.win; move++) {
+    i32 count = game_forced(&game, forced, BOARD_SIZE);
+    i32 played = 0;
+    for (i32 i = 0; i < count; i++) {
+      if (game_forced_valid(&game, forced[i])) {
+        play_hint(&game, forced[i]);
+        played++;
+      }
+    }
+    if (played > 0) continue;
+    u32 hint = game_hint(&game, handler, -1);
+    if (((hint >> 16) & 0xff) == 3) break;
+    play_hint(&game, hint);
+  }
+  if (game.win) {
+    fprintf(stderr, "\nGame is over after %d moves\n", moves);
+    return 1;
+  }
+
+  struct sample_st *out = malloc(sizeof(struct sample_st));
+  struct timespec t0, t1;
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  sample_board(&game, samples, CHAINS, threads, 1, out);
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  double secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+  // chance of danger (mine, or a monster stronger than current health) in each hidden cell, and
+  // how much probability landed on what's really there
+  printf("danger %% (hp %d):\n", game.hp);
+  double truth = 0;
+  i32 hidden = 0;
+  for (i32 y = 0; y < BOARD_H; y++) {
+    for (i32 x = 0; x < BOARD_W; x++) {
+      i32 k = x + y * BOARD_W;
+      if (GET_STATUS(game.board[k]) != S_HIDDEN) {
+        printf("   .");
+        continue;
+      }
+      float danger = 0;
+      for (i32 t = 0; t < T__SIZE; t++) {
+        if (t == T_MINE || (t != T_LV11 && game_tiles[t].threat > game.hp)) {
+          danger += out->prob[k][t];
+        }
+      }
+      printf(" %3d", (i32)(danger * 100 + 0.5f));
+      truth += out->prob[k][GET_TYPE(game.board[k])];
+      hidden++;
+    }
+    printf("\n");
+  }
+  printf(
+    "%llu samples in %.2fs (%.1fM/s), %.1f%% accepted, %.1f%% on the real tile across %d hidden\n",
+    (unsigned long long)out->samples,
+    secs,
+    out->samples / secs / 1e6,
+    100.0 * out->accepted / out->samples,
+    hidden ? 100 * truth / hidden : 0,
+    hidden
+  );
+  free(out);
+  return 0;
+}
@@ -0,0 +1,36 @@
+//
+// cryptsweeper - fight the graveyard monsters and stop death
+// by Pocket Pulp (@velipso), https://pulp.biz
+// Project Home: https://github.com/velipso/cryptsweeper
+// SPDX-License-Identifier: 0BSD
+//
+
+#include <stdint.h>
+#include <stdio.h>
+#include "../src/game.h"
+
+struct sample_st {
+  u64 samples;  // total steps over every chain, after burn in
+  u64 accepted; // steps that moved to a different board
+  // chance of each tile type in each cell; visible and pressed cells are 1 for what they are
+  float prob[BOARD_SIZE][T__SIZE];
+};
+
+// true if hidden cells a and b can trade tiles without changing any threat number the player can
+// see, or breaking a placement rule from generate_full that held before
+bool sample_swap_ok(const struct game_st *game, i32 a, i32 b);
+// propose `steps` swaps of hidden tiles like a chain does, leaving game as another board that fits
+// what the player sees, with its caches kept in sync
+void sample_shuffle(struct game_st *game, struct rnd_st *rnd, i32 steps);
+// markov chain over boards consistent with what the player sees, by swapping hidden tiles; each
+// chain has its own rnd_st stream so results only depend on the seed and number of chains
+void sample_board(
+  const struct game_st *game,
+  u64 samples,
+  i32 chains,
+  i32 threads,
+  u32 seed,
+  struct sample_st *out
+);
+void sample_help();
+int sample_main(int argc, const char **argv);
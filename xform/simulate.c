@@ -0,0 +1,285 @@
+//
+// cryptsweeper - fight the graveyard monsters and stop death
+// by Pocket Pulp (@velipso), https://pulp.biz
+// Project Home: https://github.com/velipso/cryptsweeper
+// SPDX-License-Identifier: 0BSD
+//
+
+//
+// Plays lots of games with game_hint to see how an engine change shifts difficulty.
+//
+// Game n gets the seed whisky2(seed, n), which picks its level group the same way the GBA does, and
+// every difficulty and knowledge mask is played on that seed. With "new" instead of a levels file,
+// each game generates its own boards from whisky2(game seed, difficulty). Either way the results
+// only depend on the arguments, not the number of threads.
+//
+// Output is CSV, or packed 20 byte records when the file name ends in .bin, all little endian:
+//   u32 seed
+//   i32 knowledge
+//   u32 totalexp
+//   u16 moves
+//   u8  difficulty
+//   u8  win
+//   u8  level
+//   u8  losthp
+//   u16 zero
+//
+
+#include "simulate.h"
+#include "generate.h"
+#include "pool.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+void simulate_help() {
+  printf(
+    "  simulate <levels.bin|new> <output.csv|output.bin> <games> [knowledge,...] [threads] \\\n"
+    "    [seed]\n"
+    "    Play games with hints and report win rate, level, moves and lost hp\n"
+  );
+}
+
+#define MAX_MASKS     16
+#define BATCH_GAMES   4096
+#define HIST_LEVEL    64
+#define HIST_MOVES    1024
+#define HIST_LOSTHP   256
+
+struct result_st {
+  u32 seed;
+  u32 totalexp;
+  u16 moves;
+  u8 win;
+  u8 level;
+  u8 losthp;
+};
+
+struct stats_st {
+  u64 games;
+  u64 wins;
+  u64 moves;
+  u64 level[HIST_LEVEL];
+  u64 movesh[HIST_MOVES]; // clamped, the mean uses the real count
+  u64 losthp[HIST_LOSTHP];
+};
+
+struct sim_st {
+  const u8 *levels; // NULL for new boards
+  u32 seed;
+  u32 first;        // game number of the batch's first game
+  i32 masks;
+  i32 knowledge[MAX_MASKS];
+  struct result_st *results; // [game in batch][difficulty][mask]
+};
+
+static void simulate_game(i32 index, void *user) {
+  struct sim_st *sim = user;
+  i32 game_index = index / 5;
+  i32 diff = index % 5;
+  u32 seed = whisky2(sim->seed, sim->first + game_index);
+  u8 fresh[BOARD_SIZE];
+  const u8 *board;
+  if (sim->levels) {
+    board = sim->levels + (seed & (GENERATE_SIZE - 1)) * GROUP_STRIDE + LEVEL_STRIDE * diff;
+  } else {
+    struct rnd_st rnd;
+    rnd_seed(&rnd, whisky2(seed, diff));
+    generate_board(fresh, diff, &rnd, NULL);
+    board = fresh;
+  }
+  struct result_st *out = &sim->results[index * sim->masks];
+  for (i32 m = 0; m < sim->masks; m++) {
+    struct game_st game;
+    i32 moves = play_game(&game, diff, seed, board, sim->knowledge[m]);
+    out[m].seed = seed;
+    out[m].totalexp = game.totalexp;
+    out[m].moves = moves > 0xffff ? 0xffff : moves;
+    out[m].win = game.win;
+    out[m].level = game.level;
+    out[m].losthp = game.losthp;
+  }
+}
+
+static void put_u32(u8 *p, u32 v) {
+  p[0] = v;
+  p[1] = v >> 8;
+  p[2] = v >> 16;
+  p[3] = v >> 24;
+}
+
+// smallest value with at least pct of the histogram at or below it
+static i32 percentile(const u64 *hist, i32 size, u64 total, i32 pct) {
+  u64 want = (total * pct + 99) / 100;
+  u64 sum = 0;
+  for (i32 i = 0; i < size; i++) {
+    sum += hist[i];
+    if (sum >= want && sum > 0) return i;
+  }
+  return size - 1;
+}
+
+int simulate_main(int argc, const char **argv) {
+  if (argc < 3 || argc > 6) {
+    simulate_help();
+    fprintf(
+      stderr,
+      "\nExpecting: simulate <levels.bin|new> <output.csv|output.bin> <games> [knowledge,...] "
+      "[threads] [seed]\n"
+    );
+    return 1;
+  }
+  u32 games = strtoul(argv[2], NULL, 0);
+  i32 threads = argc >= 5 ? atoi(argv[4]) : 0;
+  struct sim_st sim;
+  sim.seed = argc >= 6 ? strtoul(argv[5], NULL, 0) : 1;
+  sim.masks = 0;
+  {
+    // same masks as the acceptance tests in generate.c
+    const char *masks = argc >= 4 ? argv[3] : "0,1,7,31,63,-1";
+    const char *p = masks;
+    while (*p) {
+      if (sim.masks >= MAX_MASKS) {
+        fprintf(stderr, "\nToo many knowledge masks, max is %d\n", MAX_MASKS);
+        return 1;
+      }
+      char *end;
+      sim.knowledge[sim.masks++] = strtol(p, &end, 0);
+      if (end == p || (*end != ',' && *end != 0)) {
+        fprintf(stderr, "\nBad knowledge masks: %s\n", masks);
+        return 1;
+      }
+      p = *end == ',' ? end + 1 : end;
+    }
+  }
+  if (games == 0 || sim.masks == 0) {
+    simulate_help();
+    return 1;
+  }
+
+  u8 *levels = NULL;
+  if (strcmp(argv[0], "new") != 0) {
+    FILE *fp = fopen(argv[0], "rb");
+    if (fp == NULL) {
+      fprintf(stderr, "\nFailed to read: %s\n", argv[0]);
+      return 1;
+    }
+    levels = calloc(GENERATE_SIZE, GROUP_STRIDE);
+    i32 groups = fread(levels, GROUP_STRIDE, GENERATE_SIZE, fp);
+    fclose(fp);
+    if (groups != GENERATE_SIZE) {
+      fprintf(stderr, "\nExpecting %d level groups in: %s\n", GENERATE_SIZE, argv[0]);
+      free(levels);
+      return 1;
+    }
+  }
+  sim.levels = levels;
+
+  size_t namelen = strlen(argv[1]);
+  bool binary = namelen >= 4 && strcmp(argv[1] + namelen - 4, ".bin") == 0;
+  FILE *out = fopen(argv[1], "wb");
+  if (out == NULL) {
+    fprintf(stderr, "\nFailed to write: %s\n", argv[1]);
+    free(levels);
+    return 1;
+  }
+  if (!binary) {
+    fprintf(out, "game,seed,difficulty,knowledge,win,level,moves,losthp,totalexp\n");
+  }
+
+  sim.results = malloc(sizeof(struct result_st) * BATCH_GAMES * 5 * sim.masks);
+  struct stats_st *stats = calloc(5 * sim.masks, sizeof(struct stats_st));
+  struct timespec t0, t1;
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  printf("\n");
+  for (u32 first = 0; first < games; first += BATCH_GAMES) {
+    i32 size = games - first < BATCH_GAMES ? games - first : BATCH_GAMES;
+    sim.first = first;
+    pool_run(size * 5, threads, simulate_game, &sim);
+
+    for (i32 g = 0; g < size; g++) {
+      for (i32 diff = 0; diff < 5; diff++) {
+        for (i32 m = 0; m < sim.masks; m++) {
+          const struct result_st *r = &sim.results[(g * 5 + diff) * sim.masks + m];
+          struct stats_st *st = &stats[diff * sim.masks + m];
+          st->games++;
+          st->wins += r->win == 2;
+          st->moves += r->moves;
+          st->level[r->level < HIST_LEVEL ? r->level : HIST_LEVEL - 1]++;
+          st->movesh[r->moves < HIST_MOVES ? r->moves : HIST_MOVES - 1]++;
+          st->losthp[r->losthp]++;
+          if (binary) {
+            u8 rec[20] = {0};
+            put_u32(&rec[0], r->seed);
+            put_u32(&rec[4], sim.knowledge[m]);
+            put_u32(&rec[8], r->totalexp);
+            rec[12] = r->moves;
+            rec[13] = r->moves >> 8;
+            rec[14] = diff;
+            rec[15] = r->win;
+            rec[16] = r->level;
+            rec[17] = r->losthp;
+            fwrite(rec, sizeof(rec), 1, out);
+          } else {
+            fprintf(
+              out,
+              "%u,%u,%d,%d,%d,%d,%d,%d,%u\n",
+              first + g,
+              r->seed,
+              diff,
+              sim.knowledge[m],
+              r->win,
+              r->level,
+              r->moves,
+              r->losthp,
+              r->totalexp
+            );
+          }
+        }
+      }
+    }
+    printf("\x1b[Asimulated games %u/%u\n", first + size, games);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  double secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+  fclose(out);
+
+  printf(
+    "diff knowledge       games   win%%   level p10/p50/p90   moves mean/p50/p90"
+    "   losthp p50/p90/max\n"
+  );
+  for (i32 diff = 0; diff < 5; diff++) {
+    for (i32 m = 0; m < sim.masks; m++) {
+      const struct stats_st *st = &stats[diff * sim.masks + m];
+      printf(
+        "%4d %9d %11llu %6.2f %7d/%3d/%3d %8.1f/%3d/%3d %10d/%3d/%3d\n",
+        diff,
+        sim.knowledge[m],
+        (unsigned long long)st->games,
+        100.0 * st->wins / st->games,
+        percentile(st->level, HIST_LEVEL, st->games, 10),
+        percentile(st->level, HIST_LEVEL, st->games, 50),
+        percentile(st->level, HIST_LEVEL, st->games, 90),
+        (double)st->moves / st->games,
+        percentile(st->movesh, HIST_MOVES, st->games, 50),
+        percentile(st->movesh, HIST_MOVES, st->games, 90),
+        percentile(st->losthp, HIST_LOSTHP, st->games, 50),
+        percentile(st->losthp, HIST_LOSTHP, st->games, 90),
+        percentile(st->losthp, HIST_LOSTHP, st->games, 100)
+      );
+    }
+  }
+  u64 played = (u64)games * 5 * sim.masks;
+  printf(
+    "%llu games in %.2fs: %.0f games/s\n",
+    (unsigned long long)played,
+    secs,
+    secs > 0 ? played / secs : 0
+  );
+
+  free(stats);
+  free(sim.results);
+  free(levels);
+  return 0;
+}
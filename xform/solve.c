@@ -0,0 +1,574 @@
+//
+// cryptsweeper - fight the graveyard monsters and stop death
+// by Pocket Pulp (@velipso), https://pulp.biz
+// Project Home: https://github.com/velipso/cryptsweeper
+// SPDX-License-Identifier: 0BSD
+//
+
+//
+// Approximate expectimax solver, to measure how well a board can be played instead of how well
+// game_hint happens to play it.
+//
+// The solver never looks at the real hidden tiles. Each move searches a few boards drawn from
+// what the player can see (sample_shuffle), and plays the move with the best value averaged over
+// them. Within a drawn board, clicking a hidden cell is a chance node, where the outcomes are the
+// hidden tiles that could be swapped into that cell without changing any threat number on the
+// board or breaking a placement rule (see sample.c), weighted by how many of each there are. Moves
+// that can't hurt (game_forced, collecting items and exp) are always made right away, so the
+// search only branches on real decisions. Leaves are scored by playing the rest of the drawn board
+// with game_hint.
+//
+// Each drawn board gets an equal slice of the time budget for iterative deepening, and every node
+// and leaf is memoised in a transposition table keyed by the zobrist hash of the state.
+//
+
+#include "solve.h"
+#include "pool.h"
+#include "sample.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+void solve_help() {
+  printf(
+    "  solve <levels.bin> <output.csv> [ms per move] [threads] [groups]\n"
+    "    Play every board with an expectimax search and report how far it gets\n"
+  );
+}
+
+#define TT_BITS     16
+#define MAX_DEPTH   6
+#define BEAM_ROOT   4   // hidden cells searched at the root
+#define BEAM_INNER  2   // hidden cells searched below the root
+#define MAX_OUTCOMES 6  // most likely outcomes searched per chance node
+#define MAX_MOVES   1000
+#define SAMPLES     4     // boards drawn from what the player sees, searched per move
+#define SHUFFLE_FIRST 2000 // swaps proposed to draw the first board of a move from the real one
+#define SHUFFLE_NEXT  500  // and to draw each board after that from the one before
+
+enum solve_action {
+  A_NONE,
+  A_HINT,    // whatever game_hint would do, when that isn't clicking a hidden cell
+  A_CLICK,   // click a visible/pressed cell, where the result is known
+  A_REVEAL,  // click a hidden cell, which is a chance node
+  A_LEVELUP,
+  A__SIZE
+};
+
+struct tt_st {
+  u64 key;
+  float value;
+  i8 depth;
+  u8 action;
+  u16 cell;
+};
+
+struct search_st {
+  struct tt_st *tt;
+  u64 nodes;
+  u64 deadline;
+  bool aborted;
+  const struct game_st *root; // the drawn board being searched
+  float *values;              // [action][cell] value of each move tried at the root
+  u8 *tried;                  // [action][cell] set once values holds it
+};
+
+struct outcome_st {
+  i16 partner; // hidden cell to swap with, or -1 to keep what's there
+  i16 weight;
+};
+
+struct result_st {
+  i32 win;
+  i32 level;
+  i32 totalexp;
+  i32 moves;
+  i32 depth; // deepest search that finished for any move
+  u64 nodes;
+};
+
+static void handler(struct game_st *game, enum game_event ev, i32 x, i32 y) {
+  // do nothing
+}
+
+static u64 now_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (u64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void click(struct game_st *game, i32 k) {
+  game_hover(game, handler, k % BOARD_W, k / BOARD_W);
+  if (!game->win) {
+    game_click(game, handler);
+  }
+}
+
+// returns false if the hint gives up
+static bool play_hint(struct game_st *game, u32 hint) {
+  u8 x = hint & 0xff;
+  u8 y = (hint >> 8) & 0xff;
+  switch ((hint >> 16) & 0xff) {
+    case 0: // click
+      click(game, x + y * BOARD_W);
+      return true;
+    case 1: // note
+      game_hover(game, handler, x, y);
+      game_note(game, handler, (i8)(hint >> 24));
+      return true;
+    case 2: // levelup
+      return game_levelup(game, handler);
+  }
+  return false;
+}
+
+// make every move that can't hurt, which is the same set game_hint always does first
+static void autoplay(struct game_st *game) {
+  u32 forced[BOARD_SIZE];
+  while (!game->win) {
+    bool played = false;
+    i32 count = game_forced(game, forced, BOARD_SIZE);
+    for (i32 i = 0; i < count && !game->win; i++) {
+      if (game_forced_valid(game, forced[i])) {
+        play_hint(game, forced[i]);
+        played = true;
+      }
+    }
+    for (i32 k = 0; k < BOARD_SIZE && !game->win; k++) {
+      u8 b = game->board[k];
+      i32 s = GET_STATUS(b);
+      if (
+        (s == S_PRESSED && IS_MONSTER(b)) ||
+        (
+          (s == S_VISIBLE || s == S_PRESSED) &&
+          ((IS_ITEM(b) && GET_TYPE(b) != T_ITEM_HEAL) || IS_CHEST(b))
+        )
+      ) {
+        click(game, k);
+        played = true;
+      }
+    }
+    if (!played) break;
+  }
+}
+
+// score of a game that is over (or given up on)
+static float final_value(const struct game_st *game) {
+  if (game->win == 2) {
+    return 1000.0f + game->hp;
+  }
+  return game->totalexp;
+}
+
+// finish the game with game_hint
+static float playout(struct search_st *s, const struct game_st *game) {
+  struct game_st copy = *game;
+  for (i32 i = 0; i < MAX_MOVES && !copy.win; i++) {
+    // a hint that goes nowhere can take a long time to use up MAX_MOVES, so give up with the search
+    if (now_ns() > s->deadline) {
+      s->aborted = true;
+      break;
+    }
+    autoplay(&copy);
+    if (copy.win || !play_hint(&copy, game_hint(&copy, handler, -1))) break;
+  }
+  return final_value(&copy);
+}
+
+// what the player could find by clicking hidden cell c, grouped by type
+static i32 outcomes(const struct game_st *game, i32 c, struct outcome_st *out) {
+  i8 slot[T__SIZE];
+  memset(slot, -1, sizeof(slot));
+  i32 tc = GET_TYPE(game->board[c]);
+  slot[tc] = 0;
+  out[0].partner = -1;
+  out[0].weight = 1;
+  i32 count = 1;
+  for (i32 d = 0; d < BOARD_SIZE; d++) {
+    if (d == c || GET_STATUS(game->board[d]) != S_HIDDEN) continue;
+    i32 td = GET_TYPE(game->board[d]);
+    if (slot[td] < 0) {
+      if (!sample_swap_ok(game, c, d)) continue;
+      slot[td] = count;
+      out[count].partner = d;
+      out[count].weight = 0;
+      count++;
+    } else if (td != tc && !sample_swap_ok(game, c, d)) {
+      continue;
+    }
+    out[slot[td]].weight++;
+  }
+  return count;
+}
+
+// cheap guess at how good clicking hidden cell c is, for picking which cells to search
+static float reveal_prior(const struct game_st *game, i32 c) {
+  struct outcome_st out[T__SIZE];
+  i32 count = outcomes(game, c, out);
+  float sum = 0;
+  i32 total = 0;
+  for (i32 i = 0; i < count; i++) {
+    i32 t = GET_TYPE(game->board[out[i].partner < 0 ? c : out[i].partner]);
+    i32 threat = t == T_LV11 ? 0 : game_tiles[t].threat; // hidden mimics just show themselves
+    sum += out[i].weight * (threat > game->hp ? -100.0f : 1.0f + threat * 0.1f);
+    total += out[i].weight;
+  }
+  return sum / total;
+}
+
+static float search(
+  struct search_st *s,
+  struct game_st *game,
+  i32 depth,
+  i32 beam,
+  u8 *best_action,
+  u16 *best_cell
+);
+
+static float action_value(
+  struct search_st *s,
+  struct game_st *game,
+  i32 action,
+  i32 cell,
+  i32 depth
+) {
+  struct game_st child;
+  if (action != A_REVEAL) {
+    child = *game;
+    if (action == A_HINT) {
+      play_hint(&child, game_hint(&child, handler, -1));
+    } else if (action == A_LEVELUP) {
+      game_levelup(&child, handler);
+    } else {
+      click(&child, cell);
+    }
+    autoplay(&child);
+    return search(s, &child, depth - 1, BEAM_INNER, NULL, NULL);
+  }
+  struct outcome_st out[T__SIZE];
+  i32 count = outcomes(game, cell, out);
+  if (count > MAX_OUTCOMES) {
+    // only keep the most likely, and let them stand in for the rest
+    for (i32 i = 0; i < MAX_OUTCOMES; i++) {
+      for (i32 j = i + 1; j < count; j++) {
+        if (out[j].weight > out[i].weight) {
+          struct outcome_st temp = out[i];
+          out[i] = out[j];
+          out[j] = temp;
+        }
+      }
+    }
+    count = MAX_OUTCOMES;
+  }
+  float sum = 0;
+  i32 total = 0;
+  for (i32 i = 0; i < count && !s->aborted; i++) {
+    child = *game;
+    if (out[i].partner >= 0) {
+      game_swap(&child, cell, out[i].partner);
+    }
+    click(&child, cell);
+    autoplay(&child);
+    sum += out[i].weight * search(s, &child, depth - 1, BEAM_INNER, NULL, NULL);
+    total += out[i].weight;
+  }
+  return sum / total;
+}
+
+static float search(
+  struct search_st *s,
+  struct game_st *game,
+  i32 depth,
+  i32 beam,
+  u8 *best_action,
+  u16 *best_cell
+) {
+  s->nodes++;
+  if (game->win) {
+    return final_value(game);
+  }
+  if (now_ns() > s->deadline) {
+    s->aborted = true;
+    return 0;
+  }
+
+  bool root = game == s->root;
+  struct tt_st *tt = &s->tt[game->hash & ((1 << TT_BITS) - 1)];
+  bool hit = tt->key == game->hash;
+  if (hit && tt->depth >= depth && !root) {
+    if (best_action) *best_action = tt->action;
+    if (best_cell) *best_cell = tt->cell;
+    return tt->value;
+  }
+
+  float best;
+  u8 action = A_NONE;
+  u16 cell = 0;
+  if (depth <= 0) {
+    best = playout(s, game);
+    if (s->aborted) return 0;
+  } else {
+    // giving up is always an option
+    best = game->totalexp;
+    if (root) {
+      s->values[A_NONE * BOARD_SIZE] = best;
+      s->tried[A_NONE * BOARD_SIZE] = 1;
+    }
+    #define TRY(a, c)  do {                                \
+        float v = action_value(s, game, a, c, depth);      \
+        if (s->aborted) return 0;                          \
+        if (root) {                                        \
+          s->values[(a) * BOARD_SIZE + (c)] = v;           \
+          s->tried[(a) * BOARD_SIZE + (c)] = 1;            \
+        }                                                  \
+        if (v > best) {                                    \
+          best = v;                                        \
+          action = a;                                      \
+          cell = c;                                        \
+        }                                                  \
+      } while (0)
+
+    // the previous best goes first, so it's searched even if it falls outside the beam
+    if (hit && tt->action != A_NONE) {
+      TRY(tt->action, tt->cell);
+    }
+
+    u32 hint = game_hint(game, handler, -1);
+    i32 hint_cell = -1;
+    if (((hint >> 16) & 0xff) == 0) {
+      hint_cell = (hint & 0xff) + ((hint >> 8) & 0xff) * BOARD_W;
+      if (GET_STATUS(game->board[hint_cell]) != S_HIDDEN) {
+        hint_cell = -1;
+      }
+    }
+    if (hint_cell >= 0) {
+      if (!hit || tt->action != A_REVEAL || tt->cell != hint_cell) {
+        TRY(A_REVEAL, hint_cell);
+      }
+    } else if (((hint >> 16) & 0xff) != 3 && (!hit || tt->action != A_HINT)) {
+      TRY(A_HINT, 0);
+    }
+
+    if (game->exp >= max_exp(game) && (!hit || tt->action != A_LEVELUP)) {
+      TRY(A_LEVELUP, 0);
+    }
+
+    // rank hidden cells and search the best few
+    i32 cand[BOARD_SIZE];
+    float prior[BOARD_SIZE];
+    i32 cand_size = 0;
+    for (i32 k = 0; k < BOARD_SIZE; k++) {
+      u8 b = game->board[k];
+      i32 st = GET_STATUS(b);
+      i32 t = GET_TYPE(b);
+      bool searched = hit && tt->cell == k && (tt->action == A_REVEAL || tt->action == A_CLICK);
+      if (st == S_HIDDEN) {
+        if (game->notes[k] == -2 || k == hint_cell || searched) continue;
+        float p = reveal_prior(game, k);
+        // insertion sort, best first
+        i32 i = cand_size++;
+        for (; i > 0 && prior[i - 1] < p; i--) {
+          cand[i] = cand[i - 1];
+          prior[i] = prior[i - 1];
+        }
+        cand[i] = k;
+        prior[i] = p;
+      } else if (
+        !searched && (
+          (st == S_VISIBLE && IS_MONSTER(b) && game_tiles[t].threat <= game->hp) ||
+          (st == S_VISIBLE && t == T_WALL) ||
+          (st == S_PRESSED && t == T_WALL && game->hp > 0) ||
+          (st == S_PRESSED && t == T_ITEM_HEAL && game->hp < max_hp(game))
+        )
+      ) {
+        TRY(A_CLICK, k);
+      }
+    }
+    for (i32 i = 0; i < cand_size && i < beam && prior[i] > 0; i++) {
+      TRY(A_REVEAL, cand[i]);
+    }
+    #undef TRY
+  }
+
+  tt->key = game->hash;
+  tt->depth = depth;
+  tt->value = best;
+  tt->action = action;
+  tt->cell = cell;
+  if (best_action) *best_action = action;
+  if (best_cell) *best_cell = cell;
+  return best;
+}
+
+static void play_board(const u8 *board, i32 diff, u64 budget, struct result_st *res) {
+  struct search_st s;
+  memset(&s, 0, sizeof(s));
+  s.tt = calloc(1 << TT_BITS, sizeof(struct tt_st));
+  s.values = malloc(sizeof(float) * A__SIZE * BOARD_SIZE);
+  s.tried = malloc(A__SIZE * BOARD_SIZE);
+  // the root values of the deepest search that finished on the current drawn board, and their
+  // totals over every drawn board this move
+  float *done = malloc(sizeof(float) * A__SIZE * BOARD_SIZE);
+  u8 *done_tried = malloc(A__SIZE * BOARD_SIZE);
+  float *sum = malloc(sizeof(float) * A__SIZE * BOARD_SIZE);
+  i32 *count = malloc(sizeof(i32) * A__SIZE * BOARD_SIZE);
+  struct rnd_st rnd;
+  rnd_seed(&rnd, 1);
+  memset(res, 0, sizeof(*res));
+
+  struct game_st game;
+  game_new(&game, diff | D_VERSION1, 1, board);
+  autoplay(&game);
+  while (!game.win && res->moves < MAX_MOVES) {
+    memset(sum, 0, sizeof(float) * A__SIZE * BOARD_SIZE);
+    memset(count, 0, sizeof(i32) * A__SIZE * BOARD_SIZE);
+    struct game_st sample = game;
+    s.root = &sample;
+    for (i32 n = 0; n < SAMPLES; n++) {
+      sample_shuffle(&sample, &rnd, n == 0 ? SHUFFLE_FIRST : SHUFFLE_NEXT);
+      // iterative deepening on this board, keeping what the deepest finished search found
+      memset(done_tried, 0, A__SIZE * BOARD_SIZE);
+      s.deadline = now_ns() + budget / SAMPLES;
+      for (i32 depth = 1; depth <= MAX_DEPTH; depth++) {
+        memset(s.tried, 0, A__SIZE * BOARD_SIZE);
+        s.aborted = false;
+        search(&s, &sample, depth, BEAM_ROOT, NULL, NULL);
+        if (s.aborted) break;
+        memcpy(done, s.values, sizeof(float) * A__SIZE * BOARD_SIZE);
+        memcpy(done_tried, s.tried, A__SIZE * BOARD_SIZE);
+        if (depth > res->depth) res->depth = depth;
+      }
+      for (i32 i = 0; i < A__SIZE * BOARD_SIZE; i++) {
+        if (done_tried[i]) {
+          sum[i] += done[i];
+          count[i]++;
+        }
+      }
+    }
+    // the best average of the moves searched on the most boards, and if not even the first ply
+    // finished in time, fall back to the hint
+    u8 action = A_HINT;
+    i32 cell = 0;
+    i32 best = -1;
+    for (i32 i = 0; i < A__SIZE * BOARD_SIZE; i++) {
+      if (count[i] == 0) continue;
+      if (
+        best < 0 ||
+        count[i] > count[best] ||
+        (count[i] == count[best] && sum[i] > sum[best])
+      ) {
+        best = i;
+      }
+    }
+    if (best >= 0) {
+      action = best / BOARD_SIZE;
+      cell = best % BOARD_SIZE;
+    }
+    if (action == A_NONE) break; // giving up
+    if (action == A_HINT) {
+      if (!play_hint(&game, game_hint(&game, handler, -1))) break;
+    } else if (action == A_LEVELUP) {
+      game_levelup(&game, handler);
+    } else {
+      click(&game, cell);
+    }
+    autoplay(&game);
+    res->moves++;
+  }
+
+  res->win = game.win == 2;
+  res->level = game.level;
+  res->totalexp = game.totalexp;
+  res->nodes = s.nodes;
+  free(count);
+  free(sum);
+  free(done_tried);
+  free(done);
+  free(s.tried);
+  free(s.values);
+  free(s.tt);
+}
+
+struct solve_job_st {
+  const u8 *levels;
+  u64 budget;
+  struct result_st *results;
+  i32 total;
+  i32 done;
+};
+
+static void solve_job(i32 index, void *user) {
+  struct solve_job_st *job = user;
+  i32 group = index / 5;
+  i32 diff = index % 5;
+  play_board(
+    job->levels + group * GROUP_STRIDE + diff * LEVEL_STRIDE,
+    diff,
+    job->budget,
+    &job->results[index]
+  );
+  i32 done = __atomic_add_fetch(&job->done, 1, __ATOMIC_RELAXED);
+  if ((done & 15) == 0 || done == job->total) {
+    printf("\x1b[Asolving boards %5d/%d\n", done, job->total);
+    fflush(stdout);
+  }
+}
+
+int solve_main(int argc, const char **argv) {
+  if (argc < 2 || argc > 5) {
+    solve_help();
+    fprintf(stderr, "\nExpecting: solve <levels.bin> <output.csv> [ms per move] [threads] [groups]\n");
+    return 1;
+  }
+  i32 ms = argc >= 3 ? atoi(argv[2]) : 20;
+  i32 threads = argc >= 4 ? atoi(argv[3]) : 0;
+
+  FILE *fp = fopen(argv[0], "rb");
+  if (fp == NULL) {
+    fprintf(stderr, "\nFailed to read: %s\n", argv[0]);
+    return 1;
+  }
+  u8 *levels = calloc(GENERATE_SIZE, GROUP_STRIDE);
+  i32 groups = fread(levels, GROUP_STRIDE, GENERATE_SIZE, fp);
+  fclose(fp);
+  if (argc >= 5 && atoi(argv[4]) < groups) {
+    groups = atoi(argv[4]);
+  }
+
+  struct solve_job_st job;
+  job.levels = levels;
+  job.budget = (u64)ms * 1000000;
+  job.total = groups * 5;
+  job.done = 0;
+  job.results = calloc(job.total, sizeof(struct result_st));
+  printf("\n");
+  pool_run(job.total, threads, solve_job, &job);
+
+  fp = fopen(argv[1], "wb");
+  if (fp == NULL) {
+    fprintf(stderr, "\nFailed to write: %s\n", argv[1]);
+    free(job.results);
+    free(levels);
+    return 1;
+  }
+  fprintf(fp, "group,difficulty,win,level,totalexp,moves,depth,nodes\n");
+  i32 wins[5] = {0};
+  for (i32 i = 0; i < job.total; i++) {
+    struct result_st *r = &job.results[i];
+    fprintf(
+      fp,
+      "%d,%d,%d,%d,%d,%d,%d,%llu\n",
+      i / 5, i % 5, r->win, r->level, r->totalexp, r->moves, r->depth, (unsigned long long)r->nodes
+    );
+    wins[i % 5] += r->win;
+  }
+  fclose(fp);
+  printf(
+    "wins per difficulty: %d, %d, %d, %d, %d (of %d)\n",
+    wins[0], wins[1], wins[2], wins[3], wins[4], groups
+  );
+  free(job.results);
+  free(levels);
+  return 0;
+}
@@ -0,0 +1,13 @@
+//
+// cryptsweeper - fight the graveyard monsters and stop death
+// by Pocket Pulp (@velipso), https://pulp.biz
+// Project Home: https://github.com/velipso/cryptsweeper
+// SPDX-License-Identifier: 0BSD
+//
+
+#include <stdint.h>
+#include <stdio.h>
+#include "../src/game.h"
+
+void solve_help();
+int solve_main(int argc, const char **argv);
@@ -0,0 +1,250 @@
+//
+// cryptsweeper - fight the graveyard monsters and stop death
+// by Pocket Pulp (@velipso), https://pulp.biz
+// Project Home: https://github.com/velipso/cryptsweeper
+// SPDX-License-Identifier: 0BSD
+//
+
+//
+// Searches game_hint's scoring weights for ones that win more while wasting less hp.
+//
+// Board n gets the seed whisky2(seed, n), which picks its level group, and cycles through the
+// difficulties. Each job takes a few boards, sets each one up once, and plays a copy of it with
+// every weight vector, so every vector sees the exact same games.
+//
+
+#include "sweep.h"
+#include "generate.h"
+#include "pool.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+void sweep_help() {
+  printf(
+    "  sweep <levels.bin> <output.csv> <boards> <grid|vectors> [knowledge] [threads] [seed]\n"
+    "    Score game_hint weights over a grid, or random vectors around the defaults, and\n"
+    "    report the ones with the best trade off of win rate and lost hp\n"
+  );
+}
+
+#define BOARDS_PER_JOB  8
+
+struct outcome_st {
+  u8 win;
+  u8 losthp;
+};
+
+struct sweep_st {
+  const u8 *levels;
+  u32 seed;
+  i32 boards;
+  i32 knowledge;
+  i32 vectors;
+  const struct hint_weights_st *weights;
+  struct outcome_st *outcomes; // [board][vector]
+};
+
+struct score_st {
+  double win;
+  double losthp;
+  bool pareto;
+};
+
+static void sweep_job(i32 index, void *user) {
+  struct sweep_st *sw = user;
+  i32 end = (index + 1) * BOARDS_PER_JOB;
+  if (end > sw->boards) end = sw->boards;
+  for (i32 b = index * BOARDS_PER_JOB; b < end; b++) {
+    u32 seed = whisky2(sw->seed, b);
+    i32 diff = b % 5;
+    struct game_st start;
+    game_new(
+      &start,
+      diff | D_VERSION1,
+      seed,
+      sw->levels + (seed & (GENERATE_SIZE - 1)) * GROUP_STRIDE + LEVEL_STRIDE * diff
+    );
+    for (i32 v = 0; v < sw->vectors; v++) {
+      struct game_st game = start;
+      play_from(&game, sw->knowledge, &sw->weights[v]);
+      struct outcome_st *out = &sw->outcomes[b * sw->vectors + v];
+      out->win = game.win == 2;
+      out->losthp = game.losthp;
+    }
+  }
+}
+
+static i32 grid_weights(struct hint_weights_st *weights) {
+  static const i32 threat[] = { 3, 6, 9 };
+  static const i32 bias[] = { 0, 2, 4 };
+  static const i32 witch[] = { 0, 3, 6 };
+  static const i32 hidden[] = { 0, 2, 4 };
+  static const i32 unknown[] = { 50, 100, 200 };
+  i32 count = 0;
+  for (i32 a = 0; a < 3; a++)
+  for (i32 b = 0; b < 3; b++)
+  for (i32 c = 0; c < 3; c++)
+  for (i32 d = 0; d < 3; d++)
+  for (i32 e = 0; e < 3; e++) {
+    if (weights) {
+      struct hint_weights_st *w = &weights[count];
+      *w = hint_weights_default;
+      w->threat = threat[a];
+      w->bias = bias[b];
+      w->witch = witch[c];
+      w->hidden = hidden[d];
+      w->unknown = unknown[e];
+    }
+    count++;
+  }
+  return count;
+}
+
+static void random_weights(struct hint_weights_st *weights, i32 count, u32 seed) {
+  // the first vector is always the defaults, to compare against
+  weights[0] = hint_weights_default;
+  const struct hint_weights_st *d = &hint_weights_default;
+  for (i32 v = 1; v < count; v++) {
+    struct rnd_st rnd;
+    rnd_seed(&rnd, whisky2(seed, v));
+    struct hint_weights_st *w = &weights[v];
+    w->unknown = roll(&rnd, d->unknown * 2 + 1);
+    w->threat = roll(&rnd, d->threat * 2) + 1;
+    w->bias = roll(&rnd, d->bias * 2 + 1);
+    w->lv3 = roll(&rnd, d->lv3 * 2 + 1);
+    w->lv10 = roll(&rnd, d->lv10 * 2 + 1);
+    w->witch = roll(&rnd, d->witch * 2 + 1);
+    w->hidden = roll(&rnd, d->hidden * 2 + 1);
+  }
+}
+
+int sweep_main(int argc, const char **argv) {
+  if (argc < 4 || argc > 7) {
+    sweep_help();
+    fprintf(
+      stderr,
+      "\nExpecting: sweep <levels.bin> <output.csv> <boards> <grid|vectors> [knowledge] "
+      "[threads] [seed]\n"
+    );
+    return 1;
+  }
+  struct sweep_st sw;
+  sw.boards = atoi(argv[2]);
+  bool grid = strcmp(argv[3], "grid") == 0;
+  sw.vectors = grid ? grid_weights(NULL) : atoi(argv[3]);
+  sw.knowledge = argc >= 5 ? atoi(argv[4]) : -1;
+  i32 threads = argc >= 6 ? atoi(argv[5]) : 0;
+  sw.seed = argc >= 7 ? strtoul(argv[6], NULL, 0) : 1;
+  if (sw.boards <= 0 || sw.vectors <= 0) {
+    sweep_help();
+    return 1;
+  }
+
+  FILE *fp = fopen(argv[0], "rb");
+  if (fp == NULL) {
+    fprintf(stderr, "\nFailed to read: %s\n", argv[0]);
+    return 1;
+  }
+  u8 *levels = calloc(GENERATE_SIZE, GROUP_STRIDE);
+  i32 groups = fread(levels, GROUP_STRIDE, GENERATE_SIZE, fp);
+  fclose(fp);
+  if (groups != GENERATE_SIZE) {
+    fprintf(stderr, "\nExpecting %d level groups in: %s\n", GENERATE_SIZE, argv[0]);
+    free(levels);
+    return 1;
+  }
+  sw.levels = levels;
+
+  struct hint_weights_st *weights = malloc(sizeof(struct hint_weights_st) * sw.vectors);
+  if (grid) {
+    grid_weights(weights);
+  } else {
+    random_weights(weights, sw.vectors, sw.seed);
+  }
+  sw.weights = weights;
+  sw.outcomes = malloc(sizeof(struct outcome_st) * sw.boards * sw.vectors);
+
+  printf("playing %d boards with %d weight vectors\n", sw.boards, sw.vectors);
+  struct timespec t0, t1;
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  pool_run((sw.boards + BOARDS_PER_JOB - 1) / BOARDS_PER_JOB, threads, sweep_job, &sw);
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  double secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+  struct score_st *scores = calloc(sw.vectors, sizeof(struct score_st));
+  for (i32 v = 0; v < sw.vectors; v++) {
+    u64 wins = 0;
+    u64 losthp = 0;
+    for (i32 b = 0; b < sw.boards; b++) {
+      wins += sw.outcomes[b * sw.vectors + v].win;
+      losthp += sw.outcomes[b * sw.vectors + v].losthp;
+    }
+    scores[v].win = (double)wins / sw.boards;
+    scores[v].losthp = (double)losthp / sw.boards;
+  }
+
+  // on the front if no other vector wins at least as often with no more lost hp, and is better at
+  // one of them
+  for (i32 v = 0; v < sw.vectors; v++) {
+    scores[v].pareto = true;
+    for (i32 u = 0; u < sw.vectors && scores[v].pareto; u++) {
+      if (
+        scores[u].win >= scores[v].win &&
+        scores[u].losthp <= scores[v].losthp &&
+        (scores[u].win > scores[v].win || scores[u].losthp < scores[v].losthp)
+      ) {
+        scores[v].pareto = false;
+      }
+    }
+  }
+
+  FILE *out = fopen(argv[1], "wb");
+  if (out == NULL) {
+    fprintf(stderr, "\nFailed to write: %s\n", argv[1]);
+  } else {
+    fprintf(out, "vector,unknown,threat,bias,lv3,lv10,witch,hidden,win,losthp,pareto\n");
+    for (i32 v = 0; v < sw.vectors; v++) {
+      const struct hint_weights_st *w = &weights[v];
+      fprintf(
+        out,
+        "%d,%d,%d,%d,%d,%d,%d,%d,%.5f,%.4f,%d\n",
+        v, w->unknown, w->threat, w->bias, w->lv3, w->lv10, w->witch, w->hidden,
+        scores[v].win, scores[v].losthp, scores[v].pareto
+      );
+    }
+    fclose(out);
+  }
+
+  printf("pareto front, by win rate:\n");
+  printf("vector unknown threat bias lv3 lv10 witch hidden    win%%  losthp\n");
+  for (;;) {
+    // selection sort is plenty for the handful of vectors on the front
+    i32 best = -1;
+    for (i32 v = 0; v < sw.vectors; v++) {
+      if (scores[v].pareto && (best < 0 || scores[v].win > scores[best].win)) best = v;
+    }
+    if (best < 0) break;
+    const struct hint_weights_st *w = &weights[best];
+    printf(
+      "%6d %7d %6d %4d %3d %4d %5d %6d %7.2f %7.3f\n",
+      best, w->unknown, w->threat, w->bias, w->lv3, w->lv10, w->witch, w->hidden,
+      100 * scores[best].win, scores[best].losthp
+    );
+    scores[best].pareto = false;
+  }
+  u64 games = (u64)sw.boards * sw.vectors;
+  printf(
+    "%llu games in %.2fs: %.0f games/s\n",
+    (unsigned long long)games,
+    secs,
+    secs > 0 ? games / secs : 0
+  );
+
+  free(scores);
+  free(sw.outcomes);
+  free(weights);
+  free(levels);
+  return out == NULL;
+}
@@ -0,0 +1,247 @@
+//
+// cryptsweeper - fight the graveyard monsters and stop death
+// by Pocket Pulp (@velipso), https://pulp.biz
+// Project Home: https://github.com/velipso/cryptsweeper
+// SPDX-License-Identifier: 0BSD
+//
+
+//
+// Replays submitted runs to check their claimed result.
+//
+// The records file is a stream of records, all little endian:
+//   u32 seed
+//   u8  difficulty (as passed to game_new, so D_VERSION1 for normal games)
+//   u8  win (claimed: 0 = still playing, 1 = dead, 2 = won)
+//   u16 count
+//   u32 totalexp (claimed)
+//   u32 moves[count] (H_* encoding from game.h)
+//
+// Records are read a batch at a time and spread over the thread pool, and the verdicts are written
+// in the same order as the records.
+//
+
+#include "verify.h"
+#include "pool.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+void verify_help() {
+  printf(
+    "  verify <levels.bin> <records.bin> <verdicts.csv> [threads]\n"
+    "    Replay recorded runs and check their claimed result\n"
+  );
+}
+
+#define BATCH_RECORDS  65536
+#define BATCH_MOVES    (16 << 20)
+
+enum verdict {
+  V_OK,
+  V_MISMATCH, // replayed fine, but the result isn't what was claimed
+  V_BADMOVE,  // a move that can't be played, or moves after the game ended
+  V_BADLEVEL  // difficulty doesn't pick a board
+};
+
+static const char *verdict_names[] = { "ok", "mismatch", "badmove", "badlevel" };
+
+struct record_st {
+  u32 seed;
+  u8 difficulty;
+  u8 win;
+  u16 count;
+  u32 totalexp;
+  u32 first; // index into the batch's moves
+  // results
+  u8 verdict;
+  u8 final_win;
+  u32 final_totalexp;
+};
+
+struct batch_st {
+  const u8 *levels;
+  struct record_st *records;
+  u32 *moves;
+};
+
+static void handler(struct game_st *game, enum game_event ev, i32 x, i32 y) {
+  // do nothing
+}
+
+static void verify_record(i32 index, void *user) {
+  struct batch_st *batch = user;
+  struct record_st *rec = &batch->records[index];
+  i32 diff = rec->difficulty & D_DIFFICULTY;
+  if (
+    (rec->difficulty & ~(D_DIFFICULTY | D_ONLYMINES | D_VERSION1)) ||
+    diff > 4 ||
+    ((rec->difficulty & D_ONLYMINES) && (rec->difficulty & D_VERSION1))
+  ) {
+    rec->verdict = V_BADLEVEL;
+    return;
+  }
+  const u8 *board = batch->levels + (rec->seed & (GENERATE_SIZE - 1)) * GROUP_STRIDE +
+    LEVEL_STRIDE * ((rec->difficulty & D_ONLYMINES) ? 5 : diff);
+
+  struct game_st game;
+  game_new(&game, rec->difficulty, rec->seed, board);
+  rec->verdict = V_OK;
+  const u32 *moves = &batch->moves[rec->first];
+  for (i32 i = 0; i < rec->count; i++) {
+    u32 action = (moves[i] >> 16) & 0xff;
+    bool offboard = (moves[i] & 0xff) >= BOARD_W || ((moves[i] >> 8) & 0xff) >= BOARD_H;
+    if (game.win || action == 3 || action > 4 || (action != 2 && offboard)) {
+      rec->verdict = V_BADMOVE;
+      break;
+    }
+    // bumped clicks are still fine, the player just pressed A on something that didn't react
+    game_play(&game, handler, moves[i]);
+  }
+  rec->final_win = game.win;
+  rec->final_totalexp = game.totalexp;
+  if (rec->verdict == V_OK && (game.win != rec->win || game.totalexp != rec->totalexp)) {
+    rec->verdict = V_MISMATCH;
+  }
+}
+
+static inline u32 read_u32(const u8 *p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((u32)p[3] << 24);
+}
+
+int verify_main(int argc, const char **argv) {
+  if (argc < 3 || argc > 4) {
+    verify_help();
+    fprintf(stderr, "\nExpecting: verify <levels.bin> <records.bin> <verdicts.csv> [threads]\n");
+    return 1;
+  }
+  i32 threads = argc >= 4 ? atoi(argv[3]) : 0;
+
+  FILE *fp = fopen(argv[0], "rb");
+  if (fp == NULL) {
+    fprintf(stderr, "\nFailed to read: %s\n", argv[0]);
+    return 1;
+  }
+  u8 *levels = calloc(GENERATE_SIZE, GROUP_STRIDE);
+  i32 groups = fread(levels, GROUP_STRIDE, GENERATE_SIZE, fp);
+  fclose(fp);
+  if (groups != GENERATE_SIZE) {
+    fprintf(stderr, "\nExpecting %d level groups in: %s\n", GENERATE_SIZE, argv[0]);
+    free(levels);
+    return 1;
+  }
+
+  FILE *in = fopen(argv[1], "rb");
+  if (in == NULL) {
+    fprintf(stderr, "\nFailed to read: %s\n", argv[1]);
+    free(levels);
+    return 1;
+  }
+  FILE *out = fopen(argv[2], "wb");
+  if (out == NULL) {
+    fprintf(stderr, "\nFailed to write: %s\n", argv[2]);
+    fclose(in);
+    free(levels);
+    return 1;
+  }
+  fprintf(out, "record,verdict,win,totalexp\n");
+  printf("\n");
+
+  struct batch_st batch;
+  batch.levels = levels;
+  batch.records = malloc(sizeof(struct record_st) * BATCH_RECORDS);
+  batch.moves = malloc(sizeof(u32) * BATCH_MOVES);
+
+  u64 total = 0;
+  u64 total_moves = 0;
+  u64 counts[4] = {0};
+  bool truncated = false;
+  double busy = 0;
+  struct timespec t0, t1, t2;
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  while (!truncated) {
+    // read as many whole records as fit
+    i32 size = 0;
+    u32 used = 0;
+    while (size < BATCH_RECORDS) {
+      u8 head[12];
+      size_t got = fread(head, 1, 12, in);
+      if (got == 0) break;
+      struct record_st *rec = &batch.records[size];
+      rec->count = head[6] | (head[7] << 8);
+      if (got < 12 || used + rec->count > BATCH_MOVES) {
+        if (got == 12 && size > 0) {
+          // doesn't fit in this batch, so leave it for the next
+          fseek(in, -12, SEEK_CUR);
+          break;
+        }
+        truncated = true;
+        break;
+      }
+      rec->seed = read_u32(head);
+      rec->difficulty = head[4];
+      rec->win = head[5];
+      rec->totalexp = read_u32(head + 8);
+      rec->first = used;
+      if (fread(&batch.moves[used], 4, rec->count, in) != rec->count) {
+        truncated = true;
+        break;
+      }
+      for (i32 i = 0; i < rec->count; i++) {
+        batch.moves[used + i] = read_u32((const u8 *)&batch.moves[used + i]);
+      }
+      used += rec->count;
+      size++;
+    }
+    if (size == 0) break;
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    pool_run(size, threads, verify_record, &batch);
+    clock_gettime(CLOCK_MONOTONIC, &t2);
+    busy += (t2.tv_sec - t1.tv_sec) + (t2.tv_nsec - t1.tv_nsec) / 1e9;
+
+    for (i32 i = 0; i < size; i++) {
+      struct record_st *rec = &batch.records[i];
+      fprintf(
+        out,
+        "%llu,%s,%d,%u\n",
+        (unsigned long long)(total + i),
+        verdict_names[rec->verdict],
+        rec->final_win,
+        rec->final_totalexp
+      );
+      counts[rec->verdict]++;
+    }
+    total += size;
+    total_moves += used;
+    printf("\x1b[Averified %llu records\n", (unsigned long long)total);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t2);
+  double secs = (t2.tv_sec - t0.tv_sec) + (t2.tv_nsec - t0.tv_nsec) / 1e9;
+  fclose(out);
+  fclose(in);
+  free(batch.moves);
+  free(batch.records);
+  free(levels);
+
+  printf(
+    "%llu ok, %llu mismatch, %llu bad move, %llu bad level\n",
+    (unsigned long long)counts[V_OK],
+    (unsigned long long)counts[V_MISMATCH],
+    (unsigned long long)counts[V_BADMOVE],
+    (unsigned long long)counts[V_BADLEVEL]
+  );
+  printf(
+    "%llu replays (%llu moves) in %.2fs: %.0f replays/s, %.0f replays/s while replaying\n",
+    (unsigned long long)total,
+    (unsigned long long)total_moves,
+    secs,
+    secs > 0 ? total / secs : 0,
+    busy > 0 ? total / busy : 0
+  );
+  if (truncated) {
+    fprintf(stderr, "\nRecords file ends in the middle of a record: %s\n", argv[1]);
+    return 1;
+  }
+  return 0;
+}
@@ -22,6 +22,11 @@
 #include "generate.h"
 #include "famistudio.h"
 #include "books.h"
+#include "solve.h"
+#include "sample.h"
+#include "verify.h"
+#include "simulate.h"
+#include "sweep.h"
 
 typedef uint8_t  u8;
 typedef uint16_t u16;
@@ -56,13 +61,24 @@ static void print_usage() {
     "  copy8x8 <input.png> <palette.bin> <output.bin>\n"
     "    Outputs 8x8 tiles from 8x8 source image\n"
     "\n"
-    "  levels <seed> <output.bin>\n"
-    "    Generate levels\n"
+    "  levels <seed> <output.bin> [threads]\n"
+    "    Generate levels, the same for any number of threads, and print where the time went as\n"
+    "    JSON\n"
     "\n"
   );
   famistudio_help();
   printf("\n");
   books_help();
+  printf("\n");
+  solve_help();
+  printf("\n");
+  sample_help();
+  printf("\n");
+  verify_help();
+  printf("\n");
+  simulate_help();
+  printf("\n");
+  sweep_help();
 }
 
 // align files to 4 bytes... required to keep linker in alignment (???)
@@ -343,20 +359,20 @@ static int addpalette(const char *input, u16 *palette, int *nextpal, int maxpal)
   return 0;
 }
 
-static int levels(int seed, const char *output) {
+static int levels(int seed, const char *output, int threads) {
   FILE *fp = fopen(output, "wb");
   if (fp == NULL) {
     fprintf(stderr, "\nFailed to write: %s\n", output);
     return 1;
   }
-  struct rnd_st rnd;
-  rnd_seed(&rnd, seed);
   i32 count = GENERATE_SIZE;
-  u8 *levels = calloc(count, 128 * 6);
-  generate_levels(levels, count, &rnd);
-  fwrite(levels, 128 * 6, count, fp);
+  u8 *levels = calloc(count, GROUP_STRIDE);
+  struct generate_stats_st stats;
+  generate_levels(levels, count, seed, threads, &stats);
+  fwrite(levels, GROUP_STRIDE, count, fp);
   free(levels);
   fclose4(fp);
+  generate_stats_json(stdout, &stats);
   return 0;
 }
 
@@ -431,18 +447,28 @@ int main(int argc, const char **argv) {
     }
     return copy8x8(argv[2], argv[3], argv[4]);
   } else if (strcmp(argv[1], "levels") == 0) {
-    if (argc != 4) {
+    if (argc != 4 && argc != 5) {
       print_usage();
-      fprintf(stderr, "\nExpecting levels <seed> <output.bin>\n");
+      fprintf(stderr, "\nExpecting levels <seed> <output.bin> [threads]\n");
       return 1;
     }
-    return levels(atoi(argv[2]), argv[3]);
+    return levels(atoi(argv[2]), argv[3], argc == 5 ? atoi(argv[4]) : 0);
   } else if (strcmp(argv[1], "snd") == 0) {
     return snd_main(argc - 2, &argv[2]);
   } else if (strcmp(argv[1], "famistudio") == 0) {
     return famistudio_main(argc - 2, &argv[2]);
   } else if (strcmp(argv[1], "books") == 0) {
     return books_main(argc - 2, &argv[2]);
+  } else if (strcmp(argv[1], "solve") == 0) {
+    return solve_main(argc - 2, &argv[2]);
+  } else if (strcmp(argv[1], "sample") == 0) {
+    return sample_main(argc - 2, &argv[2]);
+  } else if (strcmp(argv[1], "verify") == 0) {
+    return verify_main(argc - 2, &argv[2]);
+  } else if (strcmp(argv[1], "simulate") == 0) {
+    return simulate_main(argc - 2, &argv[2]);
+  } else if (strcmp(argv[1], "sweep") == 0) {
+    return sweep_main(argc - 2, &argv[2]);
   } else {
     print_usage();
     fprintf(stderr, "\nUnknown command: %s\n", argv[1]);